@@ -0,0 +1,372 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Plugin.h"
+#include "Generator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/** \brief Default path of the plugin, relative to the benchmark build directory */
+#define ADVERSARIAL_DEFAULT_PLUGIN_PATH     "../../libs/segger-gdb-rtos-plugin-nano-os/lib/gcc-linux/libsegger-gdb-rtos-plugin-nano-os.so"
+
+/** \brief Default number of tasks of the generated target */
+#define ADVERSARIAL_DEFAULT_TASK_COUNT      32u
+
+/** \brief Default number of halts per image (the first one is the attach to the target) */
+#define ADVERSARIAL_DEFAULT_HALT_COUNT      3u
+
+/** \brief Address which is not mapped in the simulated target */
+#define ADVERSARIAL_UNMAPPED_ADDRESS        0xE0100000u
+
+/** \brief Address of the memory region filled with characters without a string terminator */
+#define ADVERSARIAL_TEXT_ADDRESS            0x30000000u
+
+/** \brief Size in bytes of the memory region filled with characters without a string terminator */
+#define ADVERSARIAL_TEXT_SIZE               0x1000u
+
+
+/** \brief Function corrupting the generated target */
+typedef bool (*fp_adversarial_corrupt_t)(const generator_layout_t* const layout);
+
+/** \brief Adversarial target memory image */
+typedef struct _adversarial_image_t
+{
+    /** \brief Name */
+    const char* name;
+    /** \brief Corruption of the generated target (NULL for the reference image) */
+    fp_adversarial_corrupt_t corrupt;
+} adversarial_image_t;
+
+
+
+/** \brief Write a field in all the task control blocks */
+static bool ADVERSARIAL_setTaskField(const generator_layout_t* const layout, const U32 offset, const U32 value)
+{
+    U32 i;
+    bool ret = true;
+    for (i = 0u; i < layout->task_count; i++)
+    {
+        ret = SIMULATOR_poke32(GENERATOR_getTaskAddress(layout, i) + offset, value) && ret;
+    }
+    return ret;
+}
+
+/** \brief The last task is linked to the first one : the task list never ends */
+static bool ADVERSARIAL_cycleToHead(const generator_layout_t* const layout)
+{
+    return SIMULATOR_poke32(GENERATOR_getTaskAddress(layout, layout->task_count - 1u) + GENERATOR_TASK_NEXT_OFFSET,
+                            GENERATOR_getTaskAddress(layout, 0u));
+}
+
+/** \brief The last task is linked to a task in the middle of the list : the task list never ends */
+static bool ADVERSARIAL_cycleToMiddle(const generator_layout_t* const layout)
+{
+    return SIMULATOR_poke32(GENERATOR_getTaskAddress(layout, layout->task_count - 1u) + GENERATOR_TASK_NEXT_OFFSET,
+                            GENERATOR_getTaskAddress(layout, layout->task_count / 2u));
+}
+
+/** \brief The first task is linked to itself */
+static bool ADVERSARIAL_selfLoop(const generator_layout_t* const layout)
+{
+    return SIMULATOR_poke32(GENERATOR_getTaskAddress(layout, 0u) + GENERATOR_TASK_NEXT_OFFSET, GENERATOR_getTaskAddress(layout, 0u));
+}
+
+/** \brief A task in the middle of the list is linked to an unmapped address */
+static bool ADVERSARIAL_wildNext(const generator_layout_t* const layout)
+{
+    return SIMULATOR_poke32(GENERATOR_getTaskAddress(layout, layout->task_count / 2u) + GENERATOR_TASK_NEXT_OFFSET,
+                            ADVERSARIAL_UNMAPPED_ADDRESS);
+}
+
+/** \brief The current task is at an unmapped address */
+static bool ADVERSARIAL_wildCurrentTask(const generator_layout_t* const layout)
+{
+    return SIMULATOR_poke32(layout->nano_os_address + GENERATOR_OS_CURRENT_TASK_OFFSET, ADVERSARIAL_UNMAPPED_ADDRESS);
+}
+
+/** \brief The names of the tasks and of the wait objects are at an unmapped address */
+static bool ADVERSARIAL_wildNames(const generator_layout_t* const layout)
+{
+    U32 i;
+    bool ret = ADVERSARIAL_setTaskField(layout, GENERATOR_TASK_NAME_OFFSET, ADVERSARIAL_UNMAPPED_ADDRESS);
+    for (i = 0u; i < layout->wait_object_count; i++)
+    {
+        ret = SIMULATOR_poke32(GENERATOR_getWaitObjectAddress(layout, i) + GENERATOR_WAIT_OBJECT_NAME_OFFSET, ADVERSARIAL_UNMAPPED_ADDRESS) && ret;
+    }
+    return ret;
+}
+
+/** \brief The names of the tasks are not terminated and run until the end of their memory region */
+static bool ADVERSARIAL_unterminatedNames(const generator_layout_t* const layout)
+{
+    U32 i;
+    bool ret = false;
+    U8* const text = SIMULATOR_addRegion(ADVERSARIAL_TEXT_ADDRESS, ADVERSARIAL_TEXT_SIZE);
+    if (text != NULL)
+    {
+        ret = true;
+        memset(text, 'x', ADVERSARIAL_TEXT_SIZE);
+        for (i = 0u; i < layout->task_count; i++)
+        {
+            const U32 offset = (i * 64u) % ADVERSARIAL_TEXT_SIZE;
+            ret = SIMULATOR_poke32(GENERATOR_getTaskAddress(layout, i) + GENERATOR_TASK_NAME_OFFSET, ADVERSARIAL_TEXT_ADDRESS + offset) && ret;
+        }
+    }
+    return ret;
+}
+
+/** \brief The names of the tasks are short strings at the very end of a memory region */
+static bool ADVERSARIAL_namesAtRegionEnd(const generator_layout_t* const layout)
+{
+    bool ret = false;
+    U8* const text = SIMULATOR_addRegion(ADVERSARIAL_TEXT_ADDRESS, ADVERSARIAL_TEXT_SIZE);
+    if (text != NULL)
+    {
+        memset(text, 0, ADVERSARIAL_TEXT_SIZE);
+        ret = SIMULATOR_pokeString(ADVERSARIAL_TEXT_ADDRESS + ADVERSARIAL_TEXT_SIZE - 8u, "lastone") &&
+              ADVERSARIAL_setTaskField(layout, GENERATOR_TASK_NAME_OFFSET, ADVERSARIAL_TEXT_ADDRESS + ADVERSARIAL_TEXT_SIZE - 8u);
+    }
+    return ret;
+}
+
+/** \brief The stacks of the tasks have a huge size and start at address 0 */
+static bool ADVERSARIAL_hugeStacks(const generator_layout_t* const layout)
+{
+    return ADVERSARIAL_setTaskField(layout, GENERATOR_TASK_STACK_SIZE_OFFSET, 0xFFFFFFF0u) &&
+           ADVERSARIAL_setTaskField(layout, GENERATOR_TASK_STACK_ORIGIN_OFFSET, 0u);
+}
+
+/** \brief The saved contexts of the tasks are at an unmapped address */
+static bool ADVERSARIAL_wildStackPointers(const generator_layout_t* const layout)
+{
+    return ADVERSARIAL_setTaskField(layout, GENERATOR_TASK_TOP_OF_STACK_OFFSET, ADVERSARIAL_UNMAPPED_ADDRESS);
+}
+
+/** \brief The pending tasks wait on objects at different unmapped addresses */
+static bool ADVERSARIAL_unmappedWaitObjects(const generator_layout_t* const layout)
+{
+    U32 i;
+    bool ret = true;
+    for (i = 0u; i < layout->task_count; i++)
+    {
+        const U32 task = GENERATOR_getTaskAddress(layout, i);
+        const U8* const wait_object = SIMULATOR_map(task + GENERATOR_TASK_WAIT_OBJECT_OFFSET, sizeof(U32));
+        if ((wait_object != NULL) && (memcmp(wait_object, "\0\0\0\0", sizeof(U32)) != 0))
+        {
+            ret = SIMULATOR_poke32(task + GENERATOR_TASK_WAIT_OBJECT_OFFSET, ADVERSARIAL_UNMAPPED_ADDRESS + i * GENERATOR_WAIT_OBJECT_SIZE) && ret;
+        }
+    }
+    return ret;
+}
+
+
+/** \brief Adversarial images of the corpus */
+static const adversarial_image_t adversarial_images[] = {
+                                                            { "reference", NULL },
+                                                            { "cycle_to_head", ADVERSARIAL_cycleToHead },
+                                                            { "cycle_to_middle", ADVERSARIAL_cycleToMiddle },
+                                                            { "self_loop", ADVERSARIAL_selfLoop },
+                                                            { "wild_next", ADVERSARIAL_wildNext },
+                                                            { "wild_current_task", ADVERSARIAL_wildCurrentTask },
+                                                            { "wild_names", ADVERSARIAL_wildNames },
+                                                            { "unterminated_names", ADVERSARIAL_unterminatedNames },
+                                                            { "names_at_region_end", ADVERSARIAL_namesAtRegionEnd },
+                                                            { "huge_stacks", ADVERSARIAL_hugeStacks },
+                                                            { "wild_stack_pointers", ADVERSARIAL_wildStackPointers },
+                                                            { "unmapped_wait_objects", ADVERSARIAL_unmappedWaitObjects },
+                                                            { NULL, NULL }
+                                                        };
+
+
+
+/** \brief Get the current time of a monotonic clock in ns */
+static U64 ADVERSARIAL_getTime(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((U64)now.tv_sec) * 1000000000u + (U64)now.tv_nsec;
+}
+
+/** \brief Display the command line usage */
+static void ADVERSARIAL_usage(const char* const name)
+{
+    fprintf(stderr, "Usage: %s [-p plugin] [-n tasks] [-H halts] [-l latency_ns] [-b byte_cost_ns]\n", name);
+    fprintf(stderr, "  -p : path of the plugin shared library (default: %s)\n", ADVERSARIAL_DEFAULT_PLUGIN_PATH);
+    fprintf(stderr, "  -n : number of tasks of the generated target (default: %u)\n", ADVERSARIAL_DEFAULT_TASK_COUNT);
+    fprintf(stderr, "  -H : number of halts per image (default: %u)\n", ADVERSARIAL_DEFAULT_HALT_COUNT);
+    fprintf(stderr, "  -l : probe transaction latency in ns (default: %u)\n", SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS);
+    fprintf(stderr, "  -b : probe cost per byte in ns (default: %u)\n", SIMULATOR_DEFAULT_BYTE_COST_NS);
+}
+
+/** \brief Run the halts on an image and output one CSV line per halt, returns the worst probe time of an update
+           in ns or 0 if the image can't be setup */
+static U64 ADVERSARIAL_runImage(const plugin_t* const plugin, const simulator_link_model_t* const link_model,
+                                const adversarial_image_t* const image, const U32 task_count, const U32 halt_count)
+{
+    U64 ret = 0u;
+    generator_config_t config;
+    generator_layout_t layout;
+
+    GENERATOR_defaultConfig(&config, "cortex-m4");
+    config.task_count = task_count;
+    config.wait_object_count = ((task_count + 3u) / 4u);
+
+    SIMULATOR_init(link_model, false);
+    if (GENERATOR_build(&config, &layout) && ((image->corrupt == NULL) || image->corrupt(&layout)) &&
+        (plugin->Init(SIMULATOR_getApi(), layout.core) != 0) && GENERATOR_resolveSymbols(&layout, plugin->GetSymbols()))
+    {
+        U32 halt;
+        for (halt = 0u; halt < halt_count; halt++)
+        {
+            U32 i;
+            U32 thread_count;
+            bool success;
+            simulator_stats_t update_stats;
+            simulator_stats_t total_stats;
+            const U64 start = ADVERSARIAL_getTime();
+            U64 update_end;
+
+            /* The GDB server updates the thread list and then queries every thread */
+            SIMULATOR_resetStats();
+            success = (plugin->UpdateThreads() == 0);
+            update_end = ADVERSARIAL_getTime();
+            SIMULATOR_getStats(&update_stats);
+            thread_count = plugin->GetNumThreads();
+            for (i = 0u; i < thread_count; i++)
+            {
+                char display[PLUGIN_DISPLAY_SIZE];
+                char reg_list[PLUGIN_REG_LIST_SIZE];
+                const U32 thread_id = plugin->GetThreadId(i);
+                (void)plugin->GetThreadDisplay(display, thread_id);
+                (void)plugin->GetThreadRegList(reg_list, thread_id);
+            }
+            SIMULATOR_getStats(&total_stats);
+
+            printf("%s,%u,%u,%u,%u,%u,%llu,%u,%llu,%llu,%u,%llu,%llu,%llu\n",
+                   image->name, task_count, halt, (success ? 1u : 0u), thread_count,
+                   update_stats.read_count, (unsigned long long)update_stats.read_bytes, update_stats.failed_read_count,
+                   (unsigned long long)(update_stats.link_time_ns / 1000u), (unsigned long long)((update_end - start) / 1000u),
+                   total_stats.read_count, (unsigned long long)total_stats.read_bytes, (unsigned long long)(total_stats.link_time_ns / 1000u),
+                   (unsigned long long)((ADVERSARIAL_getTime() - start) / 1000u));
+            if (update_stats.link_time_ns > ret)
+            {
+                ret = update_stats.link_time_ns;
+            }
+        }
+        if (ret == 0u)
+        {
+            /* Image setup successfully but without any read */
+            ret = 1u;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Unable to setup image %s\n", image->name);
+    }
+    SIMULATOR_release();
+
+    return ret;
+}
+
+
+/** \brief Worst case latency benchmark of the plugin : runs halts on a corpus of corrupted target memory
+           images and outputs the probe cost and the duration of each halt as CSV */
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int option;
+    plugin_t plugin;
+    const char* plugin_path = ADVERSARIAL_DEFAULT_PLUGIN_PATH;
+    U32 task_count = ADVERSARIAL_DEFAULT_TASK_COUNT;
+    U32 halt_count = ADVERSARIAL_DEFAULT_HALT_COUNT;
+    simulator_link_model_t link_model = { SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS, SIMULATOR_DEFAULT_BYTE_COST_NS };
+
+    /* Command line */
+    while ((option = getopt(argc, argv, "p:n:H:l:b:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                plugin_path = optarg;
+                break;
+            case 'n':
+                task_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'H':
+                halt_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                link_model.transaction_latency_ns = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                link_model.byte_cost_ns = (U32)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                ADVERSARIAL_usage(argv[0]);
+                ret = 1;
+                break;
+        }
+    }
+    if ((ret == 0) && (task_count < 2u))
+    {
+        fprintf(stderr, "At least 2 tasks are needed to corrupt the task list\n");
+        ret = 1;
+    }
+
+    if ((ret == 0) && PLUGIN_load(&plugin, plugin_path))
+    {
+        U64 worst_time = 0u;
+        const adversarial_image_t* image;
+        const adversarial_image_t* worst_image = NULL;
+
+        printf("image,tasks,halt,success,threads,update_reads,update_bytes,update_failed_reads,update_link_us,update_host_us,"
+               "total_reads,total_bytes,total_link_us,host_us\n");
+        for (image = adversarial_images; image->name != NULL; image++)
+        {
+            const U64 time = ADVERSARIAL_runImage(&plugin, &link_model, image, task_count, halt_count);
+            if (time == 0u)
+            {
+                ret = 1;
+            }
+            else if (time > worst_time)
+            {
+                worst_time = time;
+                worst_image = image;
+            }
+        }
+        if (worst_image != NULL)
+        {
+            fprintf(stderr, "Worst case update : %s image, %llu us of probe transactions\n",
+                    worst_image->name, (unsigned long long)(worst_time / 1000u));
+        }
+
+        PLUGIN_unload(&plugin);
+    }
+    else
+    {
+        ret = 1;
+    }
+
+    return ret;
+}
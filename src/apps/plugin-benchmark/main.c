@@ -0,0 +1,217 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Plugin.h"
+#include "Generator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/** \brief Default path of the plugin, relative to the benchmark build directory */
+#define BENCHMARK_DEFAULT_PLUGIN_PATH   "../../libs/segger-gdb-rtos-plugin-nano-os/lib/gcc-linux/libsegger-gdb-rtos-plugin-nano-os.so"
+
+/** \brief Default maximum number of tasks of the sweep */
+#define BENCHMARK_MAX_TASK_COUNT        1024u
+
+/** \brief Default number of halts per scenario (the first one is the attach to the target) */
+#define BENCHMARK_DEFAULT_HALT_COUNT    3u
+
+
+/** \brief Core configuration of a scenario */
+typedef struct _benchmark_core_t
+{
+    /** \brief Nano-OS port name */
+    const char* port_name;
+    /** \brief Percentage of tasks with a floating point context */
+    U32 fpu_percent;
+} benchmark_core_t;
+
+
+/** \brief Core configurations of the sweep */
+static const benchmark_core_t benchmark_cores[] = {
+                                                    { "cortex-m0", 0u },
+                                                    { "cortex-m3", 0u },
+                                                    { "cortex-m4", 0u },
+                                                    { "cortex-m4", 100u },
+                                                    { NULL, 0u }
+                                                  };
+
+/** \brief Pending task percentages of the sweep */
+static const U32 benchmark_pending_percents[] = { 0u, 50u, 100u };
+
+
+
+/** \brief Get the current time of a monotonic clock in ns */
+static U64 BENCHMARK_getTime(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((U64)now.tv_sec) * 1000000000u + (U64)now.tv_nsec;
+}
+
+/** \brief Display the command line usage */
+static void BENCHMARK_usage(const char* const name)
+{
+    fprintf(stderr, "Usage: %s [-p plugin] [-n max_tasks] [-H halts] [-l latency_ns] [-b byte_cost_ns]\n", name);
+    fprintf(stderr, "  -p : path of the plugin shared library (default: %s)\n", BENCHMARK_DEFAULT_PLUGIN_PATH);
+    fprintf(stderr, "  -n : maximum number of tasks, the sweep doubles the task count from 1 (default: %u)\n", BENCHMARK_MAX_TASK_COUNT);
+    fprintf(stderr, "  -H : number of halts per scenario (default: %u)\n", BENCHMARK_DEFAULT_HALT_COUNT);
+    fprintf(stderr, "  -l : probe transaction latency in ns (default: %u)\n", SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS);
+    fprintf(stderr, "  -b : probe cost per byte in ns (default: %u)\n", SIMULATOR_DEFAULT_BYTE_COST_NS);
+}
+
+/** \brief Run a scenario and output one CSV line per halt, returns false if the scenario can't be setup
+           (a failed update is part of the results and is reported in the success column) */
+static bool BENCHMARK_runScenario(const plugin_t* const plugin, const simulator_link_model_t* const link_model,
+                                  const generator_config_t* const config, const U32 halt_count)
+{
+    bool ret = false;
+    generator_layout_t layout;
+
+    SIMULATOR_init(link_model, false);
+    if (GENERATOR_build(config, &layout) && (plugin->Init(SIMULATOR_getApi(), layout.core) != 0) &&
+        GENERATOR_resolveSymbols(&layout, plugin->GetSymbols()))
+    {
+        U32 halt;
+
+        ret = true;
+        for (halt = 0u; halt < halt_count; halt++)
+        {
+            U32 i;
+            U32 thread_count;
+            bool success;
+            simulator_stats_t update_stats;
+            simulator_stats_t total_stats;
+            const U64 start = BENCHMARK_getTime();
+
+            /* The GDB server updates the thread list and then queries every thread */
+            SIMULATOR_resetStats();
+            success = (plugin->UpdateThreads() == 0);
+            SIMULATOR_getStats(&update_stats);
+            thread_count = plugin->GetNumThreads();
+            for (i = 0u; i < thread_count; i++)
+            {
+                char display[PLUGIN_DISPLAY_SIZE];
+                char reg_list[PLUGIN_REG_LIST_SIZE];
+                const U32 thread_id = plugin->GetThreadId(i);
+                (void)plugin->GetThreadDisplay(display, thread_id);
+                (void)plugin->GetThreadRegList(reg_list, thread_id);
+            }
+            SIMULATOR_getStats(&total_stats);
+
+            printf("%s,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%u,%llu,%llu,%llu\n",
+                   config->port_name, config->fpu_percent, config->task_count, config->pending_percent, halt,
+                   (success ? 1u : 0u), thread_count,
+                   update_stats.read_count, (unsigned long long)update_stats.read_bytes, (unsigned long long)(update_stats.link_time_ns / 1000u),
+                   total_stats.read_count, (unsigned long long)total_stats.read_bytes, (unsigned long long)(total_stats.link_time_ns / 1000u),
+                   (unsigned long long)((BENCHMARK_getTime() - start) / 1000u));
+
+            GENERATOR_step(&layout);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Unable to setup scenario %s / %u tasks\n", config->port_name, config->task_count);
+    }
+    SIMULATOR_release();
+
+    return ret;
+}
+
+
+/** \brief Scalability benchmark of the plugin : sweeps the task count, the core type and the fraction
+           of pending tasks over a simulated target and outputs the probe cost of each halt as CSV */
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int option;
+    plugin_t plugin;
+    const char* plugin_path = BENCHMARK_DEFAULT_PLUGIN_PATH;
+    U32 max_task_count = BENCHMARK_MAX_TASK_COUNT;
+    U32 halt_count = BENCHMARK_DEFAULT_HALT_COUNT;
+    simulator_link_model_t link_model = { SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS, SIMULATOR_DEFAULT_BYTE_COST_NS };
+
+    /* Command line */
+    while ((option = getopt(argc, argv, "p:n:H:l:b:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                plugin_path = optarg;
+                break;
+            case 'n':
+                max_task_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'H':
+                halt_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                link_model.transaction_latency_ns = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                link_model.byte_cost_ns = (U32)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                BENCHMARK_usage(argv[0]);
+                ret = 1;
+                break;
+        }
+    }
+
+    if ((ret == 0) && PLUGIN_load(&plugin, plugin_path))
+    {
+        const benchmark_core_t* core;
+
+        printf("port,fpu_percent,tasks,pending_percent,halt,success,threads,"
+               "update_reads,update_bytes,update_link_us,total_reads,total_bytes,total_link_us,host_us\n");
+        for (core = benchmark_cores; core->port_name != NULL; core++)
+        {
+            U32 task_count;
+            for (task_count = 1u; task_count <= max_task_count; task_count *= 2u)
+            {
+                U32 i;
+                for (i = 0u; i < (sizeof(benchmark_pending_percents) / sizeof(U32)); i++)
+                {
+                    generator_config_t config;
+                    GENERATOR_defaultConfig(&config, core->port_name);
+                    config.task_count = task_count;
+                    config.wait_object_count = ((task_count + 3u) / 4u);
+                    config.pending_percent = benchmark_pending_percents[i];
+                    config.fpu_percent = core->fpu_percent;
+                    if (!BENCHMARK_runScenario(&plugin, &link_model, &config, halt_count))
+                    {
+                        ret = 1;
+                    }
+                }
+            }
+        }
+
+        PLUGIN_unload(&plugin);
+    }
+    else
+    {
+        ret = 1;
+    }
+
+    return ret;
+}
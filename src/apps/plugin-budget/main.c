@@ -0,0 +1,410 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Profiler.h"
+#include "Simulator.h"
+#include "Generator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/** \brief Default path of the profile file exported by the plugin at the end of the check */
+#define BUDGET_DEFAULT_PROFILE_PATH     "plugin-budget-profile.csv"
+
+/** \brief Size in bytes of the thread display buffer given by the GDB server */
+#define BUDGET_DISPLAY_SIZE             256u
+
+/** \brief Size in bytes of the register list buffer given by the GDB server */
+#define BUDGET_REG_LIST_SIZE            4096u
+
+/** \brief Name of the counter of the probe transactions */
+#define BUDGET_PROBE_COUNTER            "probe"
+
+/** \brief Headroom in percent given to each counter over its reference measure (rounded up) */
+#define BUDGET_HEADROOM_PERCENT         10u
+
+/** \brief Name of the environment variable of the plugin disabling the stack prefetch when its value is 0 */
+#define BUDGET_STACK_PREFETCH_ENV_VAR   "NANO_OS_PLUGIN_STACK_PREFETCH"
+
+
+/** \brief Entry points of the plugin, linked statically to access its profiler */
+int RTOS_Init(const GDB_API* pAPI, U32 core);
+RTOS_SYMBOLS* RTOS_GetSymbols(void);
+U32 RTOS_GetNumThreads(void);
+U32 RTOS_GetThreadId(U32 n);
+int RTOS_GetThreadDisplay(char* pDisplay, U32 threadid);
+int RTOS_GetThreadRegList(char* pHexRegList, U32 threadid);
+int RTOS_UpdateThreads(void);
+
+
+/** \brief Measured phase of a scenario */
+typedef enum _budget_phase_t
+{
+    /** \brief Attach to the target : init, first update and query of all the threads */
+    BUDGET_PHASE_ATTACH = 0u,
+    /** \brief New halt without any change on the target */
+    BUDGET_PHASE_HALT,
+    /** \brief New halt after a single step which only changed the tick count */
+    BUDGET_PHASE_STEP,
+    /** \brief Query of the registers of all the threads */
+    BUDGET_PHASE_REGISTERS,
+    /** \brief Query of the registers of all the threads, their saved contexts being loaded on the first access */
+    BUDGET_PHASE_REGISTERS_ON_DEMAND
+} budget_phase_t;
+
+/** \brief Canonical scenario */
+typedef struct _budget_scenario_t
+{
+    /** \brief Name */
+    const char* name;
+    /** \brief Number of tasks */
+    U32 task_count;
+    /** \brief Number of wait objects */
+    U32 wait_object_count;
+    /** \brief Percentage of pending tasks */
+    U32 pending_percent;
+    /** \brief Measured phase */
+    budget_phase_t phase;
+} budget_scenario_t;
+
+/** \brief Read budget of a counter in a scenario */
+typedef struct _budget_limit_t
+{
+    /** \brief Scenario name */
+    const char* scenario;
+    /** \brief Profiler calling site name or BUDGET_PROBE_COUNTER for the probe transactions */
+    const char* counter;
+    /** \brief Reference number of reads */
+    U32 reads;
+    /** \brief Reference number of bytes read */
+    U32 bytes;
+} budget_limit_t;
+
+/** \brief Reads measured during a scenario */
+typedef struct _budget_usage_t
+{
+    /** \brief Reads of the plugin per calling site */
+    profiler_site_counters_t sites[PROFILER_SITE_MAX];
+    /** \brief Probe transactions */
+    simulator_stats_t probe;
+} budget_usage_t;
+
+
+/** \brief Canonical scenarios, all on a Cortex-M4 target with half of the tasks using the FPU */
+static const budget_scenario_t budget_scenarios[] = {
+                                                        { "cold_attach", 32u, 8u, 25u, BUDGET_PHASE_ATTACH },
+                                                        { "halt_no_change", 32u, 8u, 25u, BUDGET_PHASE_HALT },
+                                                        { "single_step", 32u, 8u, 25u, BUDGET_PHASE_STEP },
+                                                        { "all_registers", 32u, 8u, 25u, BUDGET_PHASE_REGISTERS },
+                                                        { "registers_on_demand", 32u, 8u, 25u, BUDGET_PHASE_REGISTERS_ON_DEMAND },
+                                                        { "pending_500", 500u, 5u, 100u, BUDGET_PHASE_ATTACH },
+                                                        { NULL, 0u, 0u, 0u, BUDGET_PHASE_ATTACH }
+                                                    };
+
+/** \brief Reference measures of the read budgets: a counter may exceed its reference by BUDGET_HEADROOM_PERCENT
+           so that the check does not depend on the incidental order of the reads, and a counter without reference
+           in a scenario must not be used (update them with the output of the -u option after an intended change
+           of the read pattern) */
+static const budget_limit_t budget_limits[] = {
+                                                { "cold_attach", "offsets", 20u, 280u },
+                                                { "cold_attach", "os_infos", 3u, 12u },
+                                                { "cold_attach", "tcb", 32u, 1184u },
+                                                { "cold_attach", "name", 40u, 5458u },
+                                                { "cold_attach", "read_plan", 32u, 5116u },
+                                                { "cold_attach", "probe", 56u, 19968u },
+                                                { "halt_no_change", "os_infos", 3u, 12u },
+                                                { "halt_no_change", "tcb", 1u, 2021u },
+                                                { "halt_no_change", "read_plan", 32u, 5116u },
+                                                { "halt_no_change", "probe", 33u, 15872u },
+                                                { "single_step", "os_infos", 3u, 12u },
+                                                { "single_step", "tcb", 1u, 2021u },
+                                                { "single_step", "read_plan", 32u, 5116u },
+                                                { "single_step", "probe", 33u, 15872u },
+                                                { "all_registers", "probe", 0u, 0u },
+                                                { "registers_on_demand", "stack_frame", 31u, 5012u },
+                                                { "registers_on_demand", "probe", 31u, 13568u },
+                                                { "pending_500", "offsets", 20u, 280u },
+                                                { "pending_500", "os_infos", 3u, 12u },
+                                                { "pending_500", "tcb", 500u, 18500u },
+                                                { "pending_500", "name", 536u, 73234u },
+                                                { "pending_500", "read_plan", 500u, 67928u },
+                                                { "pending_500", "probe", 676u, 238848u },
+                                                { NULL, NULL, 0u, 0u }
+                                              };
+
+
+
+/** \brief Add the headroom to a reference measure */
+static U32 BUDGET_addHeadroom(const U32 reference)
+{
+    return reference + ((reference * BUDGET_HEADROOM_PERCENT) + 99u) / 100u;
+}
+
+/** \brief Get the budget of a counter in a scenario */
+static void BUDGET_getLimit(const char* const scenario, const char* const counter, U32* const max_reads, U32* const max_bytes)
+{
+    const budget_limit_t* limit;
+
+    (*max_reads) = 0u;
+    (*max_bytes) = 0u;
+    for (limit = budget_limits; limit->scenario != NULL; limit++)
+    {
+        if ((strcmp(limit->scenario, scenario) == 0) && (strcmp(limit->counter, counter) == 0))
+        {
+            (*max_reads) = BUDGET_addHeadroom(limit->reads);
+            (*max_bytes) = BUDGET_addHeadroom(limit->bytes);
+        }
+    }
+}
+
+/** \brief Start the measure of the reads */
+static void BUDGET_startMeasure(budget_usage_t* const usage)
+{
+    PROFILER_getSiteCounters(usage->sites);
+    SIMULATOR_resetStats();
+}
+
+/** \brief Stop the measure of the reads */
+static void BUDGET_stopMeasure(budget_usage_t* const usage)
+{
+    U32 site;
+    profiler_site_counters_t sites[PROFILER_SITE_MAX];
+
+    PROFILER_getSiteCounters(sites);
+    for (site = 0u; site < PROFILER_SITE_MAX; site++)
+    {
+        usage->sites[site].reads = sites[site].reads - usage->sites[site].reads;
+        usage->sites[site].bytes = sites[site].bytes - usage->sites[site].bytes;
+    }
+    SIMULATOR_getStats(&usage->probe);
+}
+
+/** \brief Update the thread list and query all the threads as the GDB server does at each halt */
+static bool BUDGET_halt(void)
+{
+    bool ret = (RTOS_UpdateThreads() == 0);
+    if (ret)
+    {
+        U32 i;
+        const U32 thread_count = RTOS_GetNumThreads();
+        for (i = 0u; i < thread_count; i++)
+        {
+            char display[BUDGET_DISPLAY_SIZE];
+            (void)RTOS_GetThreadDisplay(display, RTOS_GetThreadId(i));
+        }
+    }
+    return ret;
+}
+
+/** \brief Run a scenario and measure the reads of its phase, returns false if the scenario fails */
+static bool BUDGET_runScenario(const budget_scenario_t* const scenario, budget_usage_t* const usage)
+{
+    bool ret = false;
+    generator_config_t config;
+    generator_layout_t layout;
+
+    GENERATOR_defaultConfig(&config, "cortex-m4");
+    config.task_count = scenario->task_count;
+    config.wait_object_count = scenario->wait_object_count;
+    config.pending_percent = scenario->pending_percent;
+    config.fpu_percent = 50u;
+
+    memset(usage, 0, sizeof(budget_usage_t));
+    SIMULATOR_init(NULL, false);
+    if (GENERATOR_build(&config, &layout))
+    {
+        if (scenario->phase == BUDGET_PHASE_ATTACH)
+        {
+            BUDGET_startMeasure(usage);
+        }
+        if (scenario->phase == BUDGET_PHASE_REGISTERS_ON_DEMAND)
+        {
+            (void)setenv(BUDGET_STACK_PREFETCH_ENV_VAR, "0", 1);
+        }
+        ret = (RTOS_Init(SIMULATOR_getApi(), layout.core) != 0) &&
+              GENERATOR_resolveSymbols(&layout, RTOS_GetSymbols()) &&
+              BUDGET_halt();
+        (void)unsetenv(BUDGET_STACK_PREFETCH_ENV_VAR);
+        if (ret)
+        {
+            switch (scenario->phase)
+            {
+                case BUDGET_PHASE_HALT:
+                    BUDGET_startMeasure(usage);
+                    ret = BUDGET_halt();
+                    break;
+
+                case BUDGET_PHASE_STEP:
+                    layout.tick_count++;
+                    SIMULATOR_poke32(layout.nano_os_address + GENERATOR_OS_TICK_COUNT_OFFSET, layout.tick_count);
+                    BUDGET_startMeasure(usage);
+                    ret = BUDGET_halt();
+                    break;
+
+                case BUDGET_PHASE_REGISTERS:
+                case BUDGET_PHASE_REGISTERS_ON_DEMAND:
+                {
+                    U32 i;
+                    const U32 thread_count = RTOS_GetNumThreads();
+                    BUDGET_startMeasure(usage);
+                    for (i = 0u; i < thread_count; i++)
+                    {
+                        /* The registers of the running thread are read from the CPU by the GDB server */
+                        char reg_list[BUDGET_REG_LIST_SIZE];
+                        (void)RTOS_GetThreadRegList(reg_list, RTOS_GetThreadId(i));
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+        BUDGET_stopMeasure(usage);
+    }
+    SIMULATOR_release();
+
+    return ret;
+}
+
+/** \brief Check a counter against its budget and display the result, returns false if the budget is exceeded */
+static bool BUDGET_checkCounter(const char* const scenario, const char* const counter, const U32 reads, const U32 bytes, const bool verbose)
+{
+    U32 max_reads;
+    U32 max_bytes;
+    bool ret;
+
+    BUDGET_getLimit(scenario, counter, &max_reads, &max_bytes);
+    ret = ((reads <= max_reads) && (bytes <= max_bytes));
+    if (verbose || !ret)
+    {
+        printf("%-20s %-12s reads %6u / %-6u bytes %8u / %-8u %s\n", scenario, counter, reads, max_reads, bytes, max_bytes,
+               (ret ? "" : "EXCEEDED"));
+    }
+    return ret;
+}
+
+/** \brief Display the measured reads of a scenario as reference entries of the budget table */
+static void BUDGET_printLimits(const char* const scenario, const budget_usage_t* const usage)
+{
+    U32 site;
+    for (site = 0u; site < PROFILER_SITE_MAX; site++)
+    {
+        if (usage->sites[site].reads != 0u)
+        {
+            printf("{ \"%s\", \"%s\", %uu, %uu },\n", scenario, PROFILER_getSiteName((profiler_site_t)site),
+                   usage->sites[site].reads, usage->sites[site].bytes);
+        }
+    }
+    printf("{ \"%s\", \"%s\", %uu, %uu },\n", scenario, BUDGET_PROBE_COUNTER,
+           usage->probe.read_count, (U32)usage->probe.read_bytes);
+}
+
+/** \brief Display the command line usage */
+static void BUDGET_usage(const char* const name)
+{
+    fprintf(stderr, "Usage: %s [-o profile_file] [-v] [-u]\n", name);
+    fprintf(stderr, "  -o : profile file exported by the plugin at the end of the check (default: %s)\n", BUDGET_DEFAULT_PROFILE_PATH);
+    fprintf(stderr, "  -v : display all the counters, not only the ones exceeding their budget\n");
+    fprintf(stderr, "  -u : display the measured reads as reference entries of the budget table instead of checking them\n");
+}
+
+
+/** \brief Read budget check of the plugin : runs canonical scenarios over a simulated target and checks
+           the number of reads and bytes read per calling site and over the probe against their budget */
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int option;
+    bool verbose = false;
+    bool update = false;
+    const char* profile_path = BUDGET_DEFAULT_PROFILE_PATH;
+    const budget_scenario_t* scenario;
+
+    /* Command line */
+    while ((option = getopt(argc, argv, "o:vu")) != -1)
+    {
+        switch (option)
+        {
+            case 'o':
+                profile_path = optarg;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'u':
+                update = true;
+                break;
+            default:
+                BUDGET_usage(argv[0]);
+                ret = 1;
+                break;
+        }
+    }
+    if ((ret == 0) && (PROFILER_ENABLED != 1))
+    {
+        fprintf(stderr, "The profiler of the plugin must be enabled to measure the reads per calling site\n");
+        ret = 1;
+    }
+
+    if (ret == 0)
+    {
+        /* The profiler of the plugin counts the reads per calling site */
+        (void)setenv(PROFILER_FILE_ENV_VAR, profile_path, 1);
+
+        for (scenario = budget_scenarios; scenario->name != NULL; scenario++)
+        {
+            budget_usage_t usage;
+            if (!BUDGET_runScenario(scenario, &usage))
+            {
+                fprintf(stderr, "Scenario %s failed\n", scenario->name);
+                ret = 1;
+            }
+            else if (update)
+            {
+                BUDGET_printLimits(scenario->name, &usage);
+            }
+            else
+            {
+                U32 site;
+                bool success = true;
+                for (site = 0u; site < PROFILER_SITE_MAX; site++)
+                {
+                    success = BUDGET_checkCounter(scenario->name, PROFILER_getSiteName((profiler_site_t)site),
+                                                  usage.sites[site].reads, usage.sites[site].bytes, verbose) && success;
+                }
+                success = BUDGET_checkCounter(scenario->name, BUDGET_PROBE_COUNTER,
+                                              usage.probe.read_count, (U32)usage.probe.read_bytes, verbose) && success;
+                if (!success)
+                {
+                    ret = ((ret == 0) ? 2 : ret);
+                }
+            }
+        }
+        if (ret == 2)
+        {
+            fprintf(stderr, "Read budget exceeded, check the profile file %s for the details\n", profile_path);
+        }
+    }
+
+    return ret;
+}
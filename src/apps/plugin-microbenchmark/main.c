@@ -0,0 +1,383 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Plugin.h"
+#include "Generator.h"
+#include "CortexM.h"
+#include "JLINKARM_Const.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/** \brief Default path of the plugin, relative to the benchmark build directory */
+#define MICROBENCH_DEFAULT_PLUGIN_PATH      "../../libs/segger-gdb-rtos-plugin-nano-os/lib/gcc-linux/libsegger-gdb-rtos-plugin-nano-os.so"
+
+/** \brief Default number of tasks of the simulated target */
+#define MICROBENCH_DEFAULT_TASK_COUNT       1000u
+
+/** \brief Default number of measured samples per benchmark */
+#define MICROBENCH_DEFAULT_SAMPLE_COUNT     200u
+
+/** \brief Default number of warm-up samples per benchmark */
+#define MICROBENCH_DEFAULT_WARMUP_COUNT     20u
+
+/** \brief Number of operations per sample of the CPU benchmarks */
+#define MICROBENCH_CPU_OPS_PER_SAMPLE       1000u
+
+/** \brief Size in bytes of the saved context used by the register formatting benchmark */
+#define MICROBENCH_FRAME_SIZE               256u
+
+
+/** \brief Benchmark context */
+typedef struct _microbench_context_t
+{
+    /** \brief Plugin under test */
+    const plugin_t* plugin;
+    /** \brief CPU port */
+    const nano_os_cpu_port_t* cpu;
+    /** \brief CPU register set */
+    const nano_os_cpu_register_set_t* reg_set;
+    /** \brief Number of registers in the register set */
+    U32 reg_count;
+    /** \brief Saved context */
+    U8 frame[MICROBENCH_FRAME_SIZE];
+    /** \brief Thread ids */
+    U32* thread_ids;
+    /** \brief Number of threads */
+    U32 thread_count;
+} microbench_context_t;
+
+/** \brief Benchmarked operation, runs op_count operations and returns a checksum of the results */
+typedef U32 (*fp_microbench_op_t)(microbench_context_t* const context, const U32 op_count);
+
+/** \brief Benchmark description */
+typedef struct _microbench_t
+{
+    /** \brief Name */
+    const char* name;
+    /** \brief Operation */
+    fp_microbench_op_t op;
+    /** \brief Indicate if a sample runs one operation per thread instead of MICROBENCH_CPU_OPS_PER_SAMPLE operations */
+    bool per_thread;
+} microbench_t;
+
+
+/** \brief Sink for the checksums so that the benchmarked operations are not optimized out */
+static volatile U32 microbench_sink;
+
+
+
+/** \brief Get the current time of a monotonic clock in ns */
+static U64 MICROBENCH_getTime(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((U64)now.tv_sec) * 1000000000u + (U64)now.tv_nsec;
+}
+
+/** \brief Compare 2 sample durations */
+static int MICROBENCH_compareSamples(const void* a, const void* b)
+{
+    const double sample_a = *((const double*)a);
+    const double sample_b = *((const double*)b);
+    int ret = 0;
+    if (sample_a < sample_b)
+    {
+        ret = -1;
+    }
+    else if (sample_a > sample_b)
+    {
+        ret = 1;
+    }
+    return ret;
+}
+
+/** \brief CPU_getRegValue() : format one register of the register set */
+static U32 MICROBENCH_getRegValue(microbench_context_t* const context, const U32 op_count)
+{
+    U32 i;
+    U32 checksum = 0u;
+    char value[32u];
+    for (i = 0u; i < op_count; i++)
+    {
+        const nano_os_cpu_reg_t* const cpu_reg = &context->reg_set->registers[i % context->reg_count];
+        const char* const end = CPU_getRegValue(context->cpu, cpu_reg, 0x20001000u, context->frame, value);
+        checksum += (U32)(end - value) + (U32)value[0u];
+    }
+    return checksum;
+}
+
+/** \brief CPU_findRegister() : look up one register of the register set by its id */
+static U32 MICROBENCH_findRegister(microbench_context_t* const context, const U32 op_count)
+{
+    U32 i;
+    U32 checksum = 0u;
+    for (i = 0u; i < op_count; i++)
+    {
+        const U32 register_id = context->reg_set->registers[i % context->reg_count].id;
+        const nano_os_cpu_reg_t* const cpu_reg = CPU_findRegister(context->reg_set, register_id);
+        checksum += ((cpu_reg != NULL) ? cpu_reg->size : 0u);
+    }
+    return checksum;
+}
+
+/** \brief CPU_computeStackFrameSize() : compute the frame size of the register set */
+static U32 MICROBENCH_computeStackFrameSize(microbench_context_t* const context, const U32 op_count)
+{
+    U32 i;
+    U32 checksum = 0u;
+    for (i = 0u; i < op_count; i++)
+    {
+        checksum += CPU_computeStackFrameSize(context->reg_set);
+    }
+    return checksum;
+}
+
+/** \brief findThread() : look up every thread by its id, through RTOS_SetThreadReg() which only looks the thread up */
+static U32 MICROBENCH_findThread(microbench_context_t* const context, const U32 op_count)
+{
+    U32 i;
+    U32 checksum = 0u;
+    char value[32u] = "00000000";
+    for (i = 0u; i < op_count; i++)
+    {
+        checksum += (U32)context->plugin->SetThreadReg(value, 0u, context->thread_ids[i % context->thread_count]);
+    }
+    return checksum;
+}
+
+/** \brief RTOS_GetThreadDisplay() : render the display string of every thread */
+static U32 MICROBENCH_getThreadDisplay(microbench_context_t* const context, const U32 op_count)
+{
+    U32 i;
+    U32 checksum = 0u;
+    char display[PLUGIN_DISPLAY_SIZE];
+    for (i = 0u; i < op_count; i++)
+    {
+        checksum += (U32)context->plugin->GetThreadDisplay(display, context->thread_ids[i % context->thread_count]);
+    }
+    return checksum;
+}
+
+/** \brief Benchmarks */
+static const microbench_t microbenchs[] = {
+                                            { "CPU_getRegValue", MICROBENCH_getRegValue, false },
+                                            { "CPU_findRegister", MICROBENCH_findRegister, false },
+                                            { "CPU_computeStackFrameSize", MICROBENCH_computeStackFrameSize, false },
+                                            { "findThread", MICROBENCH_findThread, true },
+                                            { "RTOS_GetThreadDisplay", MICROBENCH_getThreadDisplay, true },
+                                            { NULL, NULL, false }
+                                          };
+
+/** \brief Run a benchmark and output its statistics as a CSV line */
+static bool MICROBENCH_run(const microbench_t* const microbench, microbench_context_t* const context,
+                           const U32 warmup_count, const U32 sample_count)
+{
+    bool ret = false;
+    const U32 op_count = (microbench->per_thread ? context->thread_count : MICROBENCH_CPU_OPS_PER_SAMPLE);
+    double* const samples = (double*)malloc(sample_count * sizeof(double));
+    if (samples != NULL)
+    {
+        U32 i;
+        double sum = 0.0;
+
+        /* Warm-up the caches and the branch predictors */
+        for (i = 0u; i < warmup_count; i++)
+        {
+            microbench_sink += microbench->op(context, op_count);
+        }
+
+        /* Measure */
+        for (i = 0u; i < sample_count; i++)
+        {
+            const U64 start = MICROBENCH_getTime();
+            microbench_sink += microbench->op(context, op_count);
+            samples[i] = ((double)(MICROBENCH_getTime() - start)) / ((double)op_count);
+            sum += samples[i];
+        }
+
+        /* Statistics */
+        qsort(samples, sample_count, sizeof(double), MICROBENCH_compareSamples);
+        printf("%s,%u,%u,%.1f,%.1f,%.1f,%.1f\n",
+               microbench->name, op_count, sample_count,
+               samples[sample_count / 2u],
+               samples[((sample_count * 99u) / 100u < sample_count) ? ((sample_count * 99u) / 100u) : (sample_count - 1u)],
+               samples[0u],
+               sum / ((double)sample_count));
+
+        free(samples);
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Setup the CPU registers and the simulated target shared by the benchmarks */
+static bool MICROBENCH_setup(microbench_context_t* const context, const plugin_t* const plugin, const U32 task_count)
+{
+    bool ret = false;
+    generator_config_t config;
+    generator_layout_t layout;
+
+    memset(context, 0, sizeof(microbench_context_t));
+    context->plugin = plugin;
+
+    /* Simulated Cortex-M4 target with floating point contexts only, so that the largest register set is used */
+    SIMULATOR_init(NULL, false);
+    GENERATOR_defaultConfig(&config, "cortex-m4");
+    config.task_count = task_count;
+    config.wait_object_count = (task_count + 3u) / 4u;
+    config.fpu_percent = 100u;
+    if (GENERATOR_build(&config, &layout) && (plugin->Init(SIMULATOR_getApi(), layout.core) != 0) &&
+        GENERATOR_resolveSymbols(&layout, plugin->GetSymbols()) && (plugin->UpdateThreads() == 0))
+    {
+        U32 i;
+
+        /* CPU register set */
+        for (i = 0u; (g_cortex_m_cores[i].cpu_name != NULL) && (context->cpu == NULL); i++)
+        {
+            if (g_cortex_m_cores[i].core_id == JLINK_CORE_CORTEX_M4)
+            {
+                context->cpu = &g_cortex_m_cores[i];
+            }
+        }
+        if (context->cpu != NULL)
+        {
+            U8 port_data;
+            if (SIMULATOR_getApi()->pfReadU8(layout.tcb_address + GENERATOR_TASK_PORT_DATA_OFFSET, &port_data) == 0)
+            {
+                context->reg_set = context->cpu->registers_get(config.port_name, &port_data);
+            }
+        }
+        if (context->reg_set != NULL)
+        {
+            while (context->reg_set->registers[context->reg_count].name != NULL)
+            {
+                context->reg_count++;
+            }
+            for (i = 0u; i < MICROBENCH_FRAME_SIZE; i++)
+            {
+                context->frame[i] = (U8)i;
+            }
+
+            /* Thread ids as seen by the GDB server */
+            context->thread_count = plugin->GetNumThreads();
+            context->thread_ids = (U32*)malloc(context->thread_count * sizeof(U32));
+            if (context->thread_ids != NULL)
+            {
+                for (i = 0u; i < context->thread_count; i++)
+                {
+                    context->thread_ids[i] = plugin->GetThreadId(i);
+                }
+                ret = true;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Display the command line usage */
+static void MICROBENCH_usage(const char* const name)
+{
+    fprintf(stderr, "Usage: %s [-p plugin] [-n tasks] [-s samples] [-w warmup]\n", name);
+    fprintf(stderr, "  -p : path of the plugin shared library (default: %s)\n", MICROBENCH_DEFAULT_PLUGIN_PATH);
+    fprintf(stderr, "  -n : number of tasks of the simulated target (default: %u)\n", MICROBENCH_DEFAULT_TASK_COUNT);
+    fprintf(stderr, "  -s : number of measured samples per benchmark (default: %u)\n", MICROBENCH_DEFAULT_SAMPLE_COUNT);
+    fprintf(stderr, "  -w : number of warm-up samples per benchmark (default: %u)\n", MICROBENCH_DEFAULT_WARMUP_COUNT);
+}
+
+
+/** \brief Microbenchmarks of the host side hot functions of the plugin : each benchmark runs batches of
+           operations over a simulated target and outputs the per operation time statistics as CSV */
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int option;
+    plugin_t plugin;
+    microbench_context_t context;
+    const char* plugin_path = MICROBENCH_DEFAULT_PLUGIN_PATH;
+    U32 task_count = MICROBENCH_DEFAULT_TASK_COUNT;
+    U32 sample_count = MICROBENCH_DEFAULT_SAMPLE_COUNT;
+    U32 warmup_count = MICROBENCH_DEFAULT_WARMUP_COUNT;
+
+    /* Command line */
+    while ((option = getopt(argc, argv, "p:n:s:w:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                plugin_path = optarg;
+                break;
+            case 'n':
+                task_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                sample_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                warmup_count = (U32)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                MICROBENCH_usage(argv[0]);
+                ret = 1;
+                break;
+        }
+    }
+    if ((task_count == 0u) || (sample_count == 0u))
+    {
+        MICROBENCH_usage(argv[0]);
+        ret = 1;
+    }
+
+    if ((ret == 0) && PLUGIN_load(&plugin, plugin_path))
+    {
+        if (MICROBENCH_setup(&context, &plugin, task_count))
+        {
+            const microbench_t* microbench;
+
+            printf("benchmark,ops_per_sample,samples,median_ns_per_op,p99_ns_per_op,min_ns_per_op,mean_ns_per_op\n");
+            for (microbench = microbenchs; (microbench->name != NULL) && (ret == 0); microbench++)
+            {
+                if (!MICROBENCH_run(microbench, &context, warmup_count, sample_count))
+                {
+                    ret = 1;
+                }
+            }
+            free(context.thread_ids);
+        }
+        else
+        {
+            fprintf(stderr, "Unable to setup the simulated target\n");
+            ret = 1;
+        }
+
+        SIMULATOR_release();
+        PLUGIN_unload(&plugin);
+    }
+    else
+    {
+        ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,237 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Plugin.h"
+#include "Session.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/** \brief Default path of the plugin, relative to the replay build directory */
+#define REPLAY_DEFAULT_PLUGIN_PATH      "../../libs/segger-gdb-rtos-plugin-nano-os/lib/gcc-linux/libsegger-gdb-rtos-plugin-nano-os.so"
+
+
+/** \brief Names of the recorded entry points */
+static const char* replay_call_names[] = {
+                                            "RTOS_Init",
+                                            "RTOS_GetNumThreads",
+                                            "RTOS_GetCurrentThreadId",
+                                            "RTOS_GetThreadId",
+                                            "RTOS_GetThreadDisplay",
+                                            "RTOS_GetThreadReg",
+                                            "RTOS_GetThreadRegList",
+                                            "RTOS_SetThreadReg",
+                                            "RTOS_SetThreadRegList",
+                                            "RTOS_UpdateThreads"
+                                         };
+
+
+
+/** \brief Get the current time of a monotonic clock in ns */
+static U64 REPLAY_getTime(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((U64)now.tv_sec) * 1000000000u + (U64)now.tv_nsec;
+}
+
+/** \brief Replay a recorded call */
+static void REPLAY_call(const plugin_t* const plugin, const session_halt_t* const halt, const session_call_t* const call)
+{
+    char display[PLUGIN_DISPLAY_SIZE];
+    char reg_list[PLUGIN_REG_LIST_SIZE];
+
+    switch (call->call)
+    {
+        case RECORDER_CALL_INIT:
+            (void)plugin->Init(SIMULATOR_getApi(), call->arg0);
+            break;
+
+        case RECORDER_CALL_GET_NUM_THREADS:
+            (void)plugin->GetNumThreads();
+            break;
+
+        case RECORDER_CALL_GET_CURRENT_THREAD_ID:
+            (void)plugin->GetCurrentThreadId();
+            break;
+
+        case RECORDER_CALL_GET_THREAD_ID:
+            (void)plugin->GetThreadId(call->arg0);
+            break;
+
+        case RECORDER_CALL_GET_THREAD_DISPLAY:
+            (void)plugin->GetThreadDisplay(display, call->arg0);
+            break;
+
+        case RECORDER_CALL_GET_THREAD_REG:
+            (void)plugin->GetThreadReg(reg_list, call->arg0, call->arg1);
+            break;
+
+        case RECORDER_CALL_GET_THREAD_REG_LIST:
+            (void)plugin->GetThreadRegList(reg_list, call->arg0);
+            break;
+
+        case RECORDER_CALL_SET_THREAD_REG:
+            /* The written value is not recorded */
+            strcpy(reg_list, "00000000");
+            (void)plugin->SetThreadReg(reg_list, call->arg0, call->arg1);
+            break;
+
+        case RECORDER_CALL_SET_THREAD_REG_LIST:
+            strcpy(reg_list, "");
+            (void)plugin->SetThreadRegList(reg_list, call->arg0);
+            break;
+
+        case RECORDER_CALL_UPDATE_THREADS:
+        {
+            /* The GDB server gives the symbol addresses before the update */
+            U32 i;
+            RTOS_SYMBOLS* const symbols = plugin->GetSymbols();
+            for (i = 0u; (i < halt->symbol_count) && (symbols[i].name != NULL); i++)
+            {
+                symbols[i].address = halt->symbols[i];
+            }
+            (void)plugin->UpdateThreads();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/** \brief Display the command line usage */
+static void REPLAY_usage(const char* const name)
+{
+    fprintf(stderr, "Usage: %s [-p plugin] [-l latency_ns] [-b byte_cost_ns] session_file\n", name);
+    fprintf(stderr, "  -p : path of the plugin shared library (default: %s)\n", REPLAY_DEFAULT_PLUGIN_PATH);
+    fprintf(stderr, "  -l : probe transaction latency in ns (default: %u)\n", SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS);
+    fprintf(stderr, "  -b : probe cost per byte in ns (default: %u)\n", SIMULATOR_DEFAULT_BYTE_COST_NS);
+    fprintf(stderr, "The session file is recorded by the plugin when the %s environment variable is set\n", RECORDER_FILE_ENV_VAR);
+}
+
+
+/** \brief Replay of a recorded debug session : the recorded calls are run again on the plugin with the target
+           memory served from the recorded reads, the probe cost of each halt is output as CSV and the reads
+           which are not in the recording are reported */
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int option;
+    plugin_t plugin;
+    session_t session;
+    const char* plugin_path = REPLAY_DEFAULT_PLUGIN_PATH;
+    simulator_link_model_t link_model = { SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS, SIMULATOR_DEFAULT_BYTE_COST_NS };
+
+    /* Command line */
+    while ((option = getopt(argc, argv, "p:l:b:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                plugin_path = optarg;
+                break;
+            case 'l':
+                link_model.transaction_latency_ns = (U32)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                link_model.byte_cost_ns = (U32)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                ret = 1;
+                break;
+        }
+    }
+    if ((ret != 0) || (optind != (argc - 1)))
+    {
+        REPLAY_usage(argv[0]);
+        ret = 1;
+    }
+
+    if ((ret == 0) && SESSION_load(&session, argv[optind]) && PLUGIN_load(&plugin, plugin_path))
+    {
+        U32 i;
+        U32 total_missing_read_count = 0u;
+
+        SIMULATOR_init(&link_model, false);
+        printf("halt,calls,recorded_reads,recorded_bytes,replay_reads,replay_bytes,replay_link_us,missing_reads,host_us\n");
+        for (i = 0u; i < session.halt_count; i++)
+        {
+            U32 j;
+            U32 missing_read_count = 0u;
+            simulator_stats_t stats;
+            const session_halt_t* const halt = &session.halts[i];
+            const U64 start = REPLAY_getTime();
+
+            SESSION_selectHalt(halt);
+            SIMULATOR_resetStats();
+            for (j = 0u; j < halt->call_count; j++)
+            {
+                U32 k;
+                U32 count;
+                const session_area_t* missing_reads;
+                const session_call_t* const call = &halt->calls[j];
+
+                REPLAY_call(&plugin, halt, call);
+
+                /* Report the reads which are not in the recording */
+                count = SESSION_getMissingReads(&missing_reads);
+                for (k = 0u; (k < count) && (k < SESSION_MAX_MISSING_READS); k++)
+                {
+                    fprintf(stderr, "halt %u, call %u %s(%u, %u) : read of %u bytes at 0x%08x not in the recording\n",
+                            i, j, ((call->call < RECORDER_CALL_MAX) ? replay_call_names[call->call] : "?"), call->arg0, call->arg1,
+                            missing_reads[k].size, missing_reads[k].address);
+                }
+                if (count > SESSION_MAX_MISSING_READS)
+                {
+                    fprintf(stderr, "halt %u, call %u : %u more reads not in the recording\n", i, j, count - SESSION_MAX_MISSING_READS);
+                }
+                missing_read_count += count;
+                SESSION_clearMissingReads();
+            }
+            SIMULATOR_getStats(&stats);
+            total_missing_read_count += missing_read_count;
+
+            printf("%u,%u,%u,%llu,%u,%llu,%llu,%u,%llu\n",
+                   i, halt->call_count, halt->read_count, (unsigned long long)halt->read_bytes,
+                   stats.read_count, (unsigned long long)stats.read_bytes, (unsigned long long)(stats.link_time_ns / 1000u),
+                   missing_read_count, (unsigned long long)((REPLAY_getTime() - start) / 1000u));
+        }
+        if (total_missing_read_count != 0u)
+        {
+            fprintf(stderr, "%u reads were not in the recording, the behavior of the plugin has changed\n", total_missing_read_count);
+            ret = 2;
+        }
+
+        SESSION_selectHalt(NULL);
+        SIMULATOR_release();
+        PLUGIN_unload(&plugin);
+        SESSION_release(&session);
+    }
+    else
+    {
+        ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,344 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Generator.h"
+#include "JLINKARM_Const.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+/** \brief Size in bytes of the generated g_nano_os_debug_infos structure */
+#define GENERATOR_DEBUG_INFOS_SIZE      0x20u
+
+/** \brief Maximum size in bytes of the port name string */
+#define GENERATOR_PORT_NAME_SIZE        0x20u
+
+/** \brief Size in bytes of the generated g_nano_os structure */
+#define GENERATOR_OS_SIZE               0x40u
+
+/** \brief Granularity in bytes of the simulated memory regions (like real flash and RAM, the regions extend beyond the generated data) */
+#define GENERATOR_REGION_GRANULARITY    0x10000u
+
+
+/** \brief Description of a supported port */
+typedef struct _generator_port_t
+{
+    /** \brief Nano-OS port name */
+    const char* name;
+    /** \brief J-Link core identifier */
+    U32 core;
+    /** \brief Indicate if the port saves a floating point context */
+    bool vfp;
+} generator_port_t;
+
+
+/** \brief Supported ports */
+static const generator_port_t generator_ports[] = {
+                                                    { "cortex-m0", JLINK_CORE_CORTEX_M0, false },
+                                                    { "cortex-m0+", JLINK_CORE_CORTEX_M0, false },
+                                                    { "cortex-m1", JLINK_CORE_CORTEX_M1, false },
+                                                    { "cortex-m3", JLINK_CORE_CORTEX_M3, false },
+                                                    { "cortex-m4", JLINK_CORE_CORTEX_M4, true },
+                                                    { "cortex-m7", JLINK_CORE_CORTEX_M7, true },
+                                                    { "cortex-m_v8", JLINK_CORE_CORTEX_M_V8MAINL, true },
+                                                    { NULL, 0u, false }
+                                                  };
+
+/** \brief State of the pseudo-random generator */
+static U32 generator_random_state = 1u;
+
+
+
+/** \brief Get the next pseudo-random value (xorshift32) */
+static U32 GENERATOR_random(void)
+{
+    U32 x = generator_random_state;
+    x ^= x << 13u;
+    x ^= x >> 17u;
+    x ^= x << 5u;
+    generator_random_state = x;
+    return x;
+}
+
+/** \brief Find a supported port by its name */
+static const generator_port_t* GENERATOR_findPort(const char* const port_name)
+{
+    const generator_port_t* ret = NULL;
+    const generator_port_t* port = generator_ports;
+    while ((ret == NULL) && (port->name != NULL))
+    {
+        if (strcmp(port->name, port_name) == 0)
+        {
+            ret = port;
+        }
+        port++;
+    }
+    return ret;
+}
+
+/** \brief Write a name padded to the configured length in the target memory */
+static void GENERATOR_writeName(const U32 address, const char* const prefix, const U32 index, const U32 name_length)
+{
+    char name[GENERATOR_MAX_NAME_LENGTH + 1u];
+    U32 length;
+
+    (void)snprintf(name, sizeof(name), "%s_%u", prefix, index);
+    length = (U32)strlen(name);
+    if (length > name_length)
+    {
+        length = name_length;
+    }
+    while (length < name_length)
+    {
+        name[length] = '_';
+        length++;
+    }
+    name[length] = 0;
+
+    (void)SIMULATOR_pokeString(address, name);
+}
+
+/** \brief Write the g_nano_os_debug_infos structure and the port name */
+static void GENERATOR_writeDebugInfos(const U32 address, const char* const port_name)
+{
+    const U32 port_name_address = address + GENERATOR_DEBUG_INFOS_SIZE;
+    const U8 task_offsets[] = {
+                                GENERATOR_TASK_TOP_OF_STACK_OFFSET,
+                                GENERATOR_TASK_STACK_ORIGIN_OFFSET,
+                                GENERATOR_TASK_STACK_SIZE_OFFSET,
+                                GENERATOR_TASK_NAME_OFFSET,
+                                GENERATOR_TASK_STATE_OFFSET,
+                                GENERATOR_TASK_PRIORITY_OFFSET,
+                                GENERATOR_TASK_ID_OFFSET,
+                                GENERATOR_TASK_WAIT_OBJECT_OFFSET,
+                                GENERATOR_TASK_WAIT_TIMEOUT_OFFSET,
+                                GENERATOR_TASK_TIME_SLICE_OFFSET,
+                                GENERATOR_TASK_NEXT_OFFSET,
+                                GENERATOR_TASK_PORT_DATA_OFFSET,
+                                GENERATOR_WAIT_OBJECT_TYPE_OFFSET,
+                                GENERATOR_WAIT_OBJECT_ID_OFFSET,
+                                GENERATOR_WAIT_OBJECT_NAME_OFFSET
+                              };
+    U32 i;
+
+    (void)SIMULATOR_poke32(address, port_name_address);
+    (void)SIMULATOR_poke16(address + 4u, GENERATOR_OS_CURRENT_TASK_OFFSET);
+    (void)SIMULATOR_poke16(address + 6u, GENERATOR_OS_TICK_COUNT_OFFSET);
+    (void)SIMULATOR_poke16(address + 8u, GENERATOR_OS_TASK_LIST_OFFSET);
+    for (i = 0u; i < sizeof(task_offsets); i++)
+    {
+        (void)SIMULATOR_poke8(address + 10u + i, task_offsets[i]);
+    }
+    (void)SIMULATOR_pokeString(port_name_address, port_name);
+}
+
+/** \brief Write a saved context at the top of a task stack */
+static void GENERATOR_writeFrame(const U32 address, const U32 size, const U32 task_index)
+{
+    U8* const frame = SIMULATOR_map(address, size);
+    U32 i;
+    for (i = 0u; i < size; i++)
+    {
+        frame[i] = (U8)(task_index + i);
+    }
+}
+
+
+
+/** \brief Initialize a configuration with the default values for a port */
+void GENERATOR_defaultConfig(generator_config_t* const config, const char* const port_name)
+{
+    config->port_name = port_name;
+    config->task_count = 8u;
+    config->name_length = 16u;
+    config->wait_object_count = 4u;
+    config->pending_percent = 50u;
+    config->fpu_percent = 50u;
+    config->seed = 1u;
+}
+
+/** \brief Build a synthetic Nano-OS target in the simulator (SIMULATOR_init() must have been called before) */
+bool GENERATOR_build(const generator_config_t* const config, generator_layout_t* const layout)
+{
+    bool ret = false;
+    const generator_port_t* const port = GENERATOR_findPort(config->port_name);
+
+    memset(layout, 0, sizeof(generator_layout_t));
+    if ((port != NULL) && (config->task_count != 0u) && (config->name_length <= GENERATOR_MAX_NAME_LENGTH) &&
+        (strlen(config->port_name) < GENERATOR_PORT_NAME_SIZE))
+    {
+        /* Memory map */
+        const U32 name_slot_size = (config->name_length + 4u) & ~3u;
+        const U32 names_address = GENERATOR_FLASH_ADDRESS + GENERATOR_DEBUG_INFOS_SIZE + GENERATOR_PORT_NAME_SIZE;
+        const U32 flash_size = (names_address - GENERATOR_FLASH_ADDRESS) + (config->task_count + config->wait_object_count) * name_slot_size;
+        const U32 ram_size = GENERATOR_OS_SIZE + config->task_count * (GENERATOR_TCB_SIZE + GENERATOR_STACK_SIZE) +
+                             config->wait_object_count * GENERATOR_WAIT_OBJECT_SIZE;
+        const U32 region_mask = GENERATOR_REGION_GRANULARITY - 1u;
+
+        layout->core = port->core;
+        layout->debug_infos_address = GENERATOR_FLASH_ADDRESS;
+        layout->nano_os_address = GENERATOR_RAM_ADDRESS;
+        layout->tcb_address = layout->nano_os_address + GENERATOR_OS_SIZE;
+        layout->wait_object_address = layout->tcb_address + config->task_count * GENERATOR_TCB_SIZE;
+        layout->stack_address = layout->wait_object_address + config->wait_object_count * GENERATOR_WAIT_OBJECT_SIZE;
+        layout->task_count = config->task_count;
+        layout->wait_object_count = config->wait_object_count;
+        layout->running_task = 0u;
+        layout->tick_count = 0u;
+
+        if ((SIMULATOR_addRegion(GENERATOR_FLASH_ADDRESS, (flash_size + region_mask) & ~region_mask) != NULL) &&
+            (SIMULATOR_addRegion(GENERATOR_RAM_ADDRESS, (ram_size + region_mask) & ~region_mask) != NULL))
+        {
+            U32 i;
+            U32 name_address = names_address;
+
+            generator_random_state = ((config->seed != 0u) ? config->seed : 1u);
+
+            GENERATOR_writeDebugInfos(layout->debug_infos_address, config->port_name);
+
+            /* Wait objects */
+            for (i = 0u; i < config->wait_object_count; i++)
+            {
+                const U32 wait_object = GENERATOR_getWaitObjectAddress(layout, i);
+                (void)SIMULATOR_poke8(wait_object + GENERATOR_WAIT_OBJECT_TYPE_OFFSET, (U8)(1u + (GENERATOR_random() % 7u)));
+                (void)SIMULATOR_poke16(wait_object + GENERATOR_WAIT_OBJECT_ID_OFFSET, (U16)(i + 1u));
+                (void)SIMULATOR_poke32(wait_object + GENERATOR_WAIT_OBJECT_NAME_OFFSET, name_address);
+                GENERATOR_writeName(name_address, "object", i, config->name_length);
+                name_address += name_slot_size;
+            }
+
+            /* Tasks, the first one is running, the others are ready or pending */
+            for (i = 0u; i < config->task_count; i++)
+            {
+                const U32 task = GENERATOR_getTaskAddress(layout, i);
+                const U32 stack_origin = layout->stack_address + i * GENERATOR_STACK_SIZE;
+                const bool pending = ((i != 0u) && ((GENERATOR_random() % 100u) < config->pending_percent));
+                const bool use_fpu = (port->vfp && ((GENERATOR_random() % 100u) < config->fpu_percent));
+                const U32 frame_size = (use_fpu ? GENERATOR_VFP_FRAME_SIZE : GENERATOR_FRAME_SIZE);
+                const U32 top_of_stack = stack_origin + GENERATOR_STACK_SIZE - frame_size;
+                U32 wait_object = 0u;
+                U8 state = ((i == 0u) ? 3u : 1u);
+                if (pending)
+                {
+                    state = 2u;
+                    if (config->wait_object_count != 0u)
+                    {
+                        wait_object = GENERATOR_getWaitObjectAddress(layout, GENERATOR_random() % config->wait_object_count);
+                    }
+                }
+
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_TOP_OF_STACK_OFFSET, top_of_stack);
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_STACK_ORIGIN_OFFSET, stack_origin);
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_STACK_SIZE_OFFSET, GENERATOR_STACK_SIZE);
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_NAME_OFFSET, ((config->name_length != 0u) ? name_address : 0u));
+                (void)SIMULATOR_poke8(task + GENERATOR_TASK_STATE_OFFSET, state);
+                (void)SIMULATOR_poke8(task + GENERATOR_TASK_PRIORITY_OFFSET, (U8)(GENERATOR_random() % 32u));
+                (void)SIMULATOR_poke16(task + GENERATOR_TASK_ID_OFFSET, (U16)(i + 1u));
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_WAIT_OBJECT_OFFSET, wait_object);
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_WAIT_TIMEOUT_OFFSET, (pending ? (GENERATOR_random() % 1000u) : 0u));
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_TIME_SLICE_OFFSET, 10u);
+                (void)SIMULATOR_poke32(task + GENERATOR_TASK_NEXT_OFFSET, (((i + 1u) < config->task_count) ? (task + GENERATOR_TCB_SIZE) : 0u));
+                (void)SIMULATOR_poke8(task + GENERATOR_TASK_PORT_DATA_OFFSET, (use_fpu ? 1u : 0u));
+                GENERATOR_writeFrame(top_of_stack, frame_size, i);
+                if (config->name_length != 0u)
+                {
+                    GENERATOR_writeName(name_address, "task", i, config->name_length);
+                }
+                name_address += name_slot_size;
+            }
+
+            /* Kernel data */
+            (void)SIMULATOR_poke32(layout->nano_os_address + GENERATOR_OS_CURRENT_TASK_OFFSET, layout->tcb_address);
+            (void)SIMULATOR_poke32(layout->nano_os_address + GENERATOR_OS_TICK_COUNT_OFFSET, layout->tick_count);
+            (void)SIMULATOR_poke32(layout->nano_os_address + GENERATOR_OS_TASK_LIST_OFFSET, layout->tcb_address);
+
+            ret = true;
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Resolve the plugin symbols against the generated target, returns false if a mandatory symbol is unknown */
+bool GENERATOR_resolveSymbols(const generator_layout_t* const layout, RTOS_SYMBOLS* const symbols)
+{
+    bool ret = true;
+    RTOS_SYMBOLS* symbol = symbols;
+    while (symbol->name != NULL)
+    {
+        if (strcmp(symbol->name, "g_nano_os") == 0)
+        {
+            symbol->address = layout->nano_os_address;
+        }
+        else if (strcmp(symbol->name, "g_nano_os_debug_infos") == 0)
+        {
+            symbol->address = layout->debug_infos_address;
+        }
+        else if (symbol->optional == 0)
+        {
+            ret = false;
+        }
+        else
+        {
+            symbol->address = 0u;
+        }
+        symbol++;
+    }
+    return ret;
+}
+
+/** \brief Get the address of the task control block of a task */
+U32 GENERATOR_getTaskAddress(const generator_layout_t* const layout, const U32 task_index)
+{
+    return layout->tcb_address + task_index * GENERATOR_TCB_SIZE;
+}
+
+/** \brief Get the address of a wait object */
+U32 GENERATOR_getWaitObjectAddress(const generator_layout_t* const layout, const U32 wait_object_index)
+{
+    return layout->wait_object_address + wait_object_index * GENERATOR_WAIT_OBJECT_SIZE;
+}
+
+/** \brief Simulate the target running until the next halt: the tick count advances and the next ready task becomes the running one */
+void GENERATOR_step(generator_layout_t* const layout)
+{
+    U32 i;
+    bool found = false;
+
+    /* Look for the next ready task */
+    for (i = 1u; (i <= layout->task_count) && !found; i++)
+    {
+        const U32 task_index = (layout->running_task + i) % layout->task_count;
+        const U32 task = GENERATOR_getTaskAddress(layout, task_index);
+        U8* const state = SIMULATOR_map(task + GENERATOR_TASK_STATE_OFFSET, sizeof(U8));
+        if ((state != NULL) && ((*state) == 1u))
+        {
+            /* Switch the running task */
+            (void)SIMULATOR_poke8(GENERATOR_getTaskAddress(layout, layout->running_task) + GENERATOR_TASK_STATE_OFFSET, 1u);
+            (*state) = 3u;
+            (void)SIMULATOR_poke32(layout->nano_os_address + GENERATOR_OS_CURRENT_TASK_OFFSET, task);
+            layout->running_task = task_index;
+            found = true;
+        }
+    }
+
+    layout->tick_count++;
+    (void)SIMULATOR_poke32(layout->nano_os_address + GENERATOR_OS_TICK_COUNT_OFFSET, layout->tick_count);
+}
@@ -0,0 +1,155 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "Simulator.h"
+
+
+/** \brief Start address of the simulated flash (debug informations and names) */
+#define GENERATOR_FLASH_ADDRESS         0x08000000u
+
+/** \brief Start address of the simulated RAM (kernel data, task control blocks, wait objects and stacks) */
+#define GENERATOR_RAM_ADDRESS           0x20000000u
+
+/** \brief Size in bytes of a generated task control block */
+#define GENERATOR_TCB_SIZE              0x40u
+
+/** \brief Size in bytes of a generated wait object */
+#define GENERATOR_WAIT_OBJECT_SIZE      0x10u
+
+/** \brief Size in bytes of a generated task stack */
+#define GENERATOR_STACK_SIZE            0x200u
+
+/** \brief Size in bytes of a saved context without floating point registers */
+#define GENERATOR_FRAME_SIZE            68u
+
+/** \brief Size in bytes of a saved context with floating point registers */
+#define GENERATOR_VFP_FRAME_SIZE        200u
+
+/** \brief Maximum length of a generated name */
+#define GENERATOR_MAX_NAME_LENGTH       254u
+
+
+/** \brief Offset of the current task pointer in the generated nano_os_t structure */
+#define GENERATOR_OS_CURRENT_TASK_OFFSET        0u
+/** \brief Offset of the tick count in the generated nano_os_t structure */
+#define GENERATOR_OS_TICK_COUNT_OFFSET          4u
+/** \brief Offset of the global task list in the generated nano_os_t structure */
+#define GENERATOR_OS_TASK_LIST_OFFSET           8u
+
+/** \brief Offset of the top of stack in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_TOP_OF_STACK_OFFSET      0u
+/** \brief Offset of the stack origin in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_STACK_ORIGIN_OFFSET      4u
+/** \brief Offset of the stack size in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_STACK_SIZE_OFFSET        8u
+/** \brief Offset of the name pointer in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_NAME_OFFSET              12u
+/** \brief Offset of the state in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_STATE_OFFSET             16u
+/** \brief Offset of the priority in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_PRIORITY_OFFSET          17u
+/** \brief Offset of the id in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_ID_OFFSET                18u
+/** \brief Offset of the wait object pointer in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_WAIT_OBJECT_OFFSET       20u
+/** \brief Offset of the wait timeout in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_WAIT_TIMEOUT_OFFSET      24u
+/** \brief Offset of the time slice in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_TIME_SLICE_OFFSET        28u
+/** \brief Offset of the next task pointer in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_NEXT_OFFSET              32u
+/** \brief Offset of the port specific data in the generated nano_os_task_t structure */
+#define GENERATOR_TASK_PORT_DATA_OFFSET         36u
+
+/** \brief Offset of the type in the generated wait object structure */
+#define GENERATOR_WAIT_OBJECT_TYPE_OFFSET       0u
+/** \brief Offset of the id in the generated wait object structure */
+#define GENERATOR_WAIT_OBJECT_ID_OFFSET         2u
+/** \brief Offset of the name pointer in the generated wait object structure */
+#define GENERATOR_WAIT_OBJECT_NAME_OFFSET       4u
+
+
+/** \brief Synthetic target configuration */
+typedef struct _generator_config_t
+{
+    /** \brief Nano-OS port name ("cortex-m0", "cortex-m0+", "cortex-m3", "cortex-m4", "cortex-m7" or "cortex-m_v8") */
+    const char* port_name;
+    /** \brief Number of tasks */
+    U32 task_count;
+    /** \brief Length of the task and wait object names (0 = no name) */
+    U32 name_length;
+    /** \brief Number of wait objects */
+    U32 wait_object_count;
+    /** \brief Percentage of pending tasks */
+    U32 pending_percent;
+    /** \brief Percentage of tasks with a floating point context (ports with VFP only) */
+    U32 fpu_percent;
+    /** \brief Seed of the pseudo-random choices */
+    U32 seed;
+} generator_config_t;
+
+/** \brief Generated target layout */
+typedef struct _generator_layout_t
+{
+    /** \brief J-Link core identifier matching the port */
+    U32 core;
+    /** \brief Address of g_nano_os */
+    U32 nano_os_address;
+    /** \brief Address of g_nano_os_debug_infos */
+    U32 debug_infos_address;
+    /** \brief Address of the first task control block */
+    U32 tcb_address;
+    /** \brief Address of the first wait object */
+    U32 wait_object_address;
+    /** \brief Address of the first task stack */
+    U32 stack_address;
+    /** \brief Number of tasks */
+    U32 task_count;
+    /** \brief Number of wait objects */
+    U32 wait_object_count;
+    /** \brief Index of the running task */
+    U32 running_task;
+    /** \brief Tick count */
+    U32 tick_count;
+} generator_layout_t;
+
+
+/** \brief Initialize a configuration with the default values for a port */
+void GENERATOR_defaultConfig(generator_config_t* const config, const char* const port_name);
+
+/** \brief Build a synthetic Nano-OS target in the simulator (SIMULATOR_init() must have been called before) */
+bool GENERATOR_build(const generator_config_t* const config, generator_layout_t* const layout);
+
+/** \brief Resolve the plugin symbols against the generated target, returns false if a mandatory symbol is unknown */
+bool GENERATOR_resolveSymbols(const generator_layout_t* const layout, RTOS_SYMBOLS* const symbols);
+
+/** \brief Get the address of the task control block of a task */
+U32 GENERATOR_getTaskAddress(const generator_layout_t* const layout, const U32 task_index);
+
+/** \brief Get the address of a wait object */
+U32 GENERATOR_getWaitObjectAddress(const generator_layout_t* const layout, const U32 wait_object_index);
+
+/** \brief Simulate the target running until the next halt: the tick count advances and the next ready task becomes the running one */
+void GENERATOR_step(generator_layout_t* const layout);
+
+
+#endif /* GENERATOR_H */
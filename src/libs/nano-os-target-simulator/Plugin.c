@@ -0,0 +1,89 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Plugin.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <dlfcn.h>
+
+
+/** \brief Resolve an entry point of the plugin */
+static bool PLUGIN_resolve(void* const handle, const char* const name, void* const entry_point)
+{
+    void* const address = dlsym(handle, name);
+    if (address != NULL)
+    {
+        memcpy(entry_point, &address, sizeof(address));
+    }
+    else
+    {
+        fprintf(stderr, "Missing plugin entry point %s\n", name);
+    }
+    return (address != NULL);
+}
+
+/** \brief Macro to resolve an entry point of the plugin */
+#define PLUGIN_RESOLVE(entry)   ret = ret && PLUGIN_resolve(plugin->handle, "RTOS_" #entry, &plugin->entry)
+
+
+/** \brief Load an RTOS plugin shared library and resolve all its entry points */
+bool PLUGIN_load(plugin_t* const plugin, const char* const path)
+{
+    bool ret = false;
+
+    memset(plugin, 0, sizeof(plugin_t));
+    plugin->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (plugin->handle != NULL)
+    {
+        ret = true;
+        PLUGIN_RESOLVE(Init);
+        PLUGIN_RESOLVE(GetVersion);
+        PLUGIN_RESOLVE(GetSymbols);
+        PLUGIN_RESOLVE(GetNumThreads);
+        PLUGIN_RESOLVE(GetCurrentThreadId);
+        PLUGIN_RESOLVE(GetThreadId);
+        PLUGIN_RESOLVE(GetThreadDisplay);
+        PLUGIN_RESOLVE(GetThreadReg);
+        PLUGIN_RESOLVE(GetThreadRegList);
+        PLUGIN_RESOLVE(SetThreadReg);
+        PLUGIN_RESOLVE(SetThreadRegList);
+        PLUGIN_RESOLVE(UpdateThreads);
+        if (!ret)
+        {
+            PLUGIN_unload(plugin);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Unable to load plugin %s : %s\n", path, dlerror());
+    }
+
+    return ret;
+}
+
+/** \brief Unload an RTOS plugin shared library */
+void PLUGIN_unload(plugin_t* const plugin)
+{
+    if (plugin->handle != NULL)
+    {
+        (void)dlclose(plugin->handle);
+    }
+    memset(plugin, 0, sizeof(plugin_t));
+}
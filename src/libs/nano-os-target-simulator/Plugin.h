@@ -0,0 +1,75 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include "RTOSPlugin.h"
+
+#include <stdbool.h>
+
+
+/** \brief Size in bytes of the thread display buffer given by the GDB server */
+#define PLUGIN_DISPLAY_SIZE         256u
+
+/** \brief Size in bytes of the register list buffer given by the GDB server */
+#define PLUGIN_REG_LIST_SIZE        4096u
+
+
+/** \brief Entry points of a dynamically loaded RTOS plugin */
+typedef struct _plugin_t
+{
+    /** \brief Handle of the shared library */
+    void* handle;
+
+    /** \brief RTOS_Init() */
+    int (*Init)(const GDB_API* pAPI, U32 core);
+    /** \brief RTOS_GetVersion() */
+    U32 (*GetVersion)(void);
+    /** \brief RTOS_GetSymbols() */
+    RTOS_SYMBOLS* (*GetSymbols)(void);
+    /** \brief RTOS_GetNumThreads() */
+    U32 (*GetNumThreads)(void);
+    /** \brief RTOS_GetCurrentThreadId() */
+    U32 (*GetCurrentThreadId)(void);
+    /** \brief RTOS_GetThreadId() */
+    U32 (*GetThreadId)(U32 n);
+    /** \brief RTOS_GetThreadDisplay() */
+    int (*GetThreadDisplay)(char* pDisplay, U32 threadid);
+    /** \brief RTOS_GetThreadReg() */
+    int (*GetThreadReg)(char* pHexRegVal, U32 RegIndex, U32 threadid);
+    /** \brief RTOS_GetThreadRegList() */
+    int (*GetThreadRegList)(char* pHexRegList, U32 threadid);
+    /** \brief RTOS_SetThreadReg() */
+    int (*SetThreadReg)(char* pHexRegVal, U32 RegIndex, U32 threadid);
+    /** \brief RTOS_SetThreadRegList() */
+    int (*SetThreadRegList)(char* pHexRegList, U32 threadid);
+    /** \brief RTOS_UpdateThreads() */
+    int (*UpdateThreads)(void);
+} plugin_t;
+
+
+/** \brief Load an RTOS plugin shared library and resolve all its entry points */
+bool PLUGIN_load(plugin_t* const plugin, const char* const path);
+
+/** \brief Unload an RTOS plugin shared library */
+void PLUGIN_unload(plugin_t* const plugin);
+
+
+#endif /* PLUGIN_H */
@@ -0,0 +1,411 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Session.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/** \brief Recorded read */
+typedef struct _session_read_t
+{
+    /** \brief Target memory area, data points to the file content */
+    session_area_t area;
+    /** \brief Indicate if the read succeeded */
+    bool success;
+} session_read_t;
+
+
+/** \brief Halt whose image is currently serving the simulated target memory */
+static const session_halt_t* session_selected_halt = NULL;
+
+/** \brief Reads which were not in the recording */
+static session_area_t session_missing_reads[SESSION_MAX_MISSING_READS];
+
+/** \brief Number of reads which were not in the recording */
+static U32 session_missing_read_count = 0u;
+
+
+
+/** \brief Read a 32 bits little endian value */
+static U32 SESSION_get32(const U8* const data)
+{
+    return ((U32)data[0u]) | (((U32)data[1u]) << 8u) | (((U32)data[2u]) << 16u) | (((U32)data[3u]) << 24u);
+}
+
+/** \brief Compare the address of 2 reads */
+static int SESSION_compareReads(const void* a, const void* b)
+{
+    const session_read_t* const read_a = (const session_read_t*)a;
+    const session_read_t* const read_b = (const session_read_t*)b;
+    int ret = 0;
+    if (read_a->area.address < read_b->area.address)
+    {
+        ret = -1;
+    }
+    else if (read_a->area.address > read_b->area.address)
+    {
+        ret = 1;
+    }
+    return ret;
+}
+
+/** \brief Build the sparse memory image of a halt from its recorded reads */
+static bool SESSION_buildImage(session_halt_t* const halt, session_read_t* const reads, const U32 read_count)
+{
+    bool ret = true;
+    U32 i;
+
+    halt->areas = (session_area_t*)calloc(read_count + 1u, sizeof(session_area_t));
+    halt->failed_areas = (session_area_t*)calloc(read_count + 1u, sizeof(session_area_t));
+    ret = ((halt->areas != NULL) && (halt->failed_areas != NULL));
+    if (ret)
+    {
+        U32 first_read = 0u;
+        U64 end = 0u;
+
+        /* Merge the overlapping and contiguous reads into areas */
+        qsort(reads, read_count, sizeof(session_read_t), SESSION_compareReads);
+        for (i = 0u; (i < read_count) && ret; i++)
+        {
+            const session_read_t* const read = &reads[i];
+            if (!read->success)
+            {
+                halt->failed_areas[halt->failed_area_count] = read->area;
+                halt->failed_area_count++;
+            }
+            else if ((halt->area_count != 0u) && (read->area.address <= end))
+            {
+                if ((((U64)read->area.address) + read->area.size) > end)
+                {
+                    end = ((U64)read->area.address) + read->area.size;
+                }
+                halt->areas[halt->area_count - 1u].size = (U32)(end - halt->areas[halt->area_count - 1u].address);
+            }
+            else
+            {
+                halt->areas[halt->area_count].address = read->area.address;
+                halt->areas[halt->area_count].size = read->area.size;
+                halt->area_count++;
+                end = ((U64)read->area.address) + read->area.size;
+            }
+        }
+
+        /* Fill the areas with the recorded content */
+        for (i = 0u; (i < halt->area_count) && ret; i++)
+        {
+            session_area_t* const area = &halt->areas[i];
+            area->data = (U8*)malloc((area->size != 0u) ? area->size : 1u);
+            ret = (area->data != NULL);
+            while (ret && (first_read < read_count) &&
+                   ((!reads[first_read].success) || ((((U64)reads[first_read].area.address) + reads[first_read].area.size) <= (((U64)area->address) + area->size))))
+            {
+                const session_read_t* const read = &reads[first_read];
+                if (read->success)
+                {
+                    memcpy(&area->data[read->area.address - area->address], read->area.data, read->area.size);
+                }
+                first_read++;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Start a new halt in a session */
+static session_halt_t* SESSION_newHalt(session_t* const session)
+{
+    session_halt_t* halt = NULL;
+    session_halt_t* const halts = (session_halt_t*)realloc(session->halts, (session->halt_count + 1u) * sizeof(session_halt_t));
+    if (halts != NULL)
+    {
+        session->halts = halts;
+        halt = &halts[session->halt_count];
+        memset(halt, 0, sizeof(session_halt_t));
+        session->halt_count++;
+    }
+    return halt;
+}
+
+/** \brief Add a call to a halt */
+static bool SESSION_addCall(session_halt_t* const halt, const U8* const record)
+{
+    bool ret = false;
+    session_call_t* const calls = (session_call_t*)realloc(halt->calls, (halt->call_count + 1u) * sizeof(session_call_t));
+    if (calls != NULL)
+    {
+        session_call_t* const call = &calls[halt->call_count];
+        call->call = (recorder_call_t)record[0u];
+        call->arg0 = SESSION_get32(&record[1u]);
+        call->arg1 = SESSION_get32(&record[5u]);
+        halt->calls = calls;
+        halt->call_count++;
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Add a read to the list of the reads of a halt */
+static bool SESSION_addRead(session_read_t** const reads, U32* const read_count, U32* const read_capacity, const session_read_t* const read)
+{
+    bool ret = true;
+    if ((*read_count) == (*read_capacity))
+    {
+        const U32 capacity = (((*read_capacity) != 0u) ? (2u * (*read_capacity)) : 256u);
+        session_read_t* const new_reads = (session_read_t*)realloc((*reads), capacity * sizeof(session_read_t));
+        ret = (new_reads != NULL);
+        if (ret)
+        {
+            (*reads) = new_reads;
+            (*read_capacity) = capacity;
+        }
+    }
+    if (ret)
+    {
+        (*reads)[(*read_count)] = (*read);
+        (*read_count)++;
+    }
+    return ret;
+}
+
+/** \brief Parse the records of a session file */
+static bool SESSION_parse(session_t* const session, const U8* const content, const U32 size)
+{
+    bool ret = (size >= 8u) && (SESSION_get32(content) == RECORDER_FILE_MAGIC) && (SESSION_get32(&content[4u]) == RECORDER_FILE_VERSION);
+    U32 offset = 8u;
+    session_read_t* reads = NULL;
+    U32 read_count = 0u;
+    U32 read_capacity = 0u;
+
+    /* Calls before the first update belong to an initial halt */
+    session_halt_t* halt = (ret ? SESSION_newHalt(session) : NULL);
+    ret = (halt != NULL);
+    while (ret && (offset < size))
+    {
+        const U8 tag = content[offset];
+        const U8* const record = &content[offset + 1u];
+        const U32 available = size - offset - 1u;
+        switch (tag)
+        {
+            case RECORDER_TAG_CALL:
+            {
+                ret = (available >= 9u) && SESSION_addCall(halt, record);
+                offset += 10u;
+                break;
+            }
+
+            case RECORDER_TAG_SYMBOLS:
+            {
+                /* Symbols are recorded just before each update which starts a new halt */
+                const U32 count = ((available >= 1u) ? record[0u] : 0u);
+                ret = (available >= 1u) && (count <= RECORDER_MAX_SYMBOLS) && (available >= (1u + 4u * count)) &&
+                      SESSION_buildImage(halt, reads, read_count);
+                if (ret)
+                {
+                    U32 i;
+                    read_count = 0u;
+                    halt = SESSION_newHalt(session);
+                    ret = (halt != NULL);
+                    for (i = 0u; (i < count) && ret; i++)
+                    {
+                        halt->symbols[i] = SESSION_get32(&record[1u + 4u * i]);
+                    }
+                    if (ret)
+                    {
+                        halt->symbol_count = count;
+                    }
+                }
+                offset += 2u + 4u * count;
+                break;
+            }
+
+            case RECORDER_TAG_READ:
+            {
+                session_read_t read;
+                ret = (available >= 9u);
+                if (ret)
+                {
+                    read.success = (record[0u] != 0u);
+                    read.area.address = SESSION_get32(&record[1u]);
+                    read.area.size = SESSION_get32(&record[5u]);
+                    read.area.data = (read.success ? (U8*)&record[9u] : NULL);
+                    ret = ((!read.success) || ((available - 9u) >= read.area.size)) &&
+                          SESSION_addRead(&reads, &read_count, &read_capacity, &read);
+                    offset += 10u + (read.success ? read.area.size : 0u);
+                    if (ret)
+                    {
+                        halt->read_count++;
+                        halt->read_bytes += read.area.size;
+                    }
+                }
+                break;
+            }
+
+            default:
+            {
+                ret = false;
+                break;
+            }
+        }
+        if (!ret)
+        {
+            fprintf(stderr, "Invalid session record at offset %u\n", offset);
+        }
+    }
+    ret = ret && SESSION_buildImage(halt, reads, read_count);
+    free(reads);
+
+    return ret;
+}
+
+/** \brief Memory handler serving the image of the selected halt */
+static U8* SESSION_memoryHandler(const U32 address, const U32 size)
+{
+    U8* ret = NULL;
+    const session_halt_t* const halt = session_selected_halt;
+    const U64 end = ((U64)address) + size;
+    U32 first = 0u;
+    U32 last = halt->area_count;
+    U32 i;
+    bool failed = false;
+
+    /* Look for the last area starting before the address */
+    while ((last - first) > 1u)
+    {
+        const U32 middle = (first + last) / 2u;
+        if (halt->areas[middle].address <= address)
+        {
+            first = middle;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    if ((halt->area_count != 0u) && (halt->areas[first].address <= address) &&
+        (end <= (((U64)halt->areas[first].address) + halt->areas[first].size)))
+    {
+        ret = &halt->areas[first].data[address - halt->areas[first].address];
+    }
+    else
+    {
+        /* Reads which already failed in the recording are not reported */
+        for (i = 0u; (i < halt->failed_area_count) && !failed; i++)
+        {
+            const session_area_t* const area = &halt->failed_areas[i];
+            failed = ((area->address <= address) && (end <= (((U64)area->address) + area->size)));
+        }
+        if (!failed)
+        {
+            if (session_missing_read_count < SESSION_MAX_MISSING_READS)
+            {
+                session_missing_reads[session_missing_read_count].address = address;
+                session_missing_reads[session_missing_read_count].size = size;
+                session_missing_reads[session_missing_read_count].data = NULL;
+            }
+            session_missing_read_count++;
+        }
+    }
+
+    return ret;
+}
+
+
+
+/** \brief Load a session file recorded by the plugin */
+bool SESSION_load(session_t* const session, const char* const path)
+{
+    bool ret = false;
+    FILE* const file = fopen(path, "rb");
+
+    memset(session, 0, sizeof(session_t));
+    if (file != NULL)
+    {
+        long size;
+        U8* content = NULL;
+        if ((fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) > 0) && (fseek(file, 0, SEEK_SET) == 0))
+        {
+            content = (U8*)malloc((size_t)size);
+            if ((content != NULL) && (fread(content, 1u, (size_t)size, file) == (size_t)size))
+            {
+                ret = SESSION_parse(session, content, (U32)size);
+            }
+        }
+        free(content);
+        fclose(file);
+        if (!ret)
+        {
+            SESSION_release(session);
+        }
+    }
+    if (!ret)
+    {
+        fprintf(stderr, "Unable to load session file %s\n", path);
+    }
+
+    return ret;
+}
+
+/** \brief Release a session */
+void SESSION_release(session_t* const session)
+{
+    U32 i;
+    for (i = 0u; i < session->halt_count; i++)
+    {
+        U32 j;
+        session_halt_t* const halt = &session->halts[i];
+        if (halt->areas != NULL)
+        {
+            for (j = 0u; j < halt->area_count; j++)
+            {
+                free(halt->areas[j].data);
+            }
+        }
+        free(halt->areas);
+        free(halt->failed_areas);
+        free(halt->calls);
+    }
+    free(session->halts);
+    memset(session, 0, sizeof(session_t));
+}
+
+/** \brief Serve the simulated target memory from the image of a recorded halt */
+void SESSION_selectHalt(const session_halt_t* const halt)
+{
+    session_selected_halt = halt;
+    SIMULATOR_setMemoryHandler((halt != NULL) ? SESSION_memoryHandler : NULL);
+    SESSION_clearMissingReads();
+}
+
+/** \brief Get the reads which were not in the recording since the last clear,
+           returns their number (only the first SESSION_MAX_MISSING_READS are kept) */
+U32 SESSION_getMissingReads(const session_area_t** const missing_reads)
+{
+    (*missing_reads) = session_missing_reads;
+    return session_missing_read_count;
+}
+
+/** \brief Clear the reads which were not in the recording */
+void SESSION_clearMissingReads(void)
+{
+    session_missing_read_count = 0u;
+}
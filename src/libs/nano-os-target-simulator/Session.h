@@ -0,0 +1,105 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "Simulator.h"
+#include "Recorder.h"
+
+
+/** \brief Maximum number of missing reads kept for reporting between 2 calls to SESSION_clearMissingReads() */
+#define SESSION_MAX_MISSING_READS   16u
+
+
+/** \brief Recorded call to an exported entry point */
+typedef struct _session_call_t
+{
+    /** \brief Entry point */
+    recorder_call_t call;
+    /** \brief First argument */
+    U32 arg0;
+    /** \brief Second argument */
+    U32 arg1;
+} session_call_t;
+
+/** \brief Target memory area */
+typedef struct _session_area_t
+{
+    /** \brief Start address */
+    U32 address;
+    /** \brief Size in bytes */
+    U32 size;
+    /** \brief Content (NULL if the area could not be read) */
+    U8* data;
+} session_area_t;
+
+/** \brief Recorded halt : calls from an update to the next one and sparse image of the target memory read meanwhile */
+typedef struct _session_halt_t
+{
+    /** \brief Calls */
+    session_call_t* calls;
+    /** \brief Number of calls */
+    U32 call_count;
+    /** \brief Symbol addresses given to the update */
+    U32 symbols[RECORDER_MAX_SYMBOLS];
+    /** \brief Number of symbols */
+    U32 symbol_count;
+    /** \brief Readable areas, sorted by address and merged */
+    session_area_t* areas;
+    /** \brief Number of readable areas */
+    U32 area_count;
+    /** \brief Areas which could not be read */
+    session_area_t* failed_areas;
+    /** \brief Number of areas which could not be read */
+    U32 failed_area_count;
+    /** \brief Number of recorded reads */
+    U32 read_count;
+    /** \brief Number of recorded bytes */
+    U64 read_bytes;
+} session_halt_t;
+
+/** \brief Recorded debug session */
+typedef struct _session_t
+{
+    /** \brief Halts */
+    session_halt_t* halts;
+    /** \brief Number of halts */
+    U32 halt_count;
+} session_t;
+
+
+/** \brief Load a session file recorded by the plugin */
+bool SESSION_load(session_t* const session, const char* const path);
+
+/** \brief Release a session */
+void SESSION_release(session_t* const session);
+
+/** \brief Serve the simulated target memory from the image of a recorded halt */
+void SESSION_selectHalt(const session_halt_t* const halt);
+
+/** \brief Get the reads which were not in the recording since the last clear,
+           returns their number (only the first SESSION_MAX_MISSING_READS are kept) */
+U32 SESSION_getMissingReads(const session_area_t** const missing_reads);
+
+/** \brief Clear the reads which were not in the recording */
+void SESSION_clearMissingReads(void);
+
+
+#endif /* SESSION_H */
@@ -0,0 +1,472 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Simulator.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+
+/** \brief Memory region of the simulated target */
+typedef struct _simulator_region_t
+{
+    /** \brief Start address in the target memory */
+    U32 address;
+    /** \brief Size in bytes */
+    U32 size;
+    /** \brief Content */
+    U8* data;
+} simulator_region_t;
+
+
+/** \brief Memory regions of the simulated target */
+static simulator_region_t simulator_regions[SIMULATOR_MAX_REGIONS];
+
+/** \brief Number of memory regions of the simulated target */
+static U32 simulator_region_count = 0u;
+
+/** \brief Probe link cost model */
+static simulator_link_model_t simulator_link_model = { SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS, SIMULATOR_DEFAULT_BYTE_COST_NS };
+
+/** \brief Probe activity counters */
+static simulator_stats_t simulator_stats;
+
+/** \brief Handler serving the target memory instead of the memory regions */
+static fp_simulator_memory_handler_t simulator_memory_handler = NULL;
+
+/** \brief Indicate if the plugin messages must be displayed */
+static bool simulator_verbose = false;
+
+
+
+/** \brief Account a probe transaction in the counters */
+static void SIMULATOR_transaction(const U32 size)
+{
+    simulator_stats.link_time_ns += simulator_link_model.transaction_latency_ns;
+    simulator_stats.link_time_ns += ((U64)simulator_link_model.byte_cost_ns) * size;
+}
+
+/** \brief Account a read transaction and get the host address of the read area */
+static const U8* SIMULATOR_read(const U32 address, const U32 size)
+{
+    const U8* const data = SIMULATOR_map(address, size);
+
+    SIMULATOR_transaction(size);
+    simulator_stats.read_count++;
+    if (data != NULL)
+    {
+        simulator_stats.read_bytes += size;
+    }
+    else
+    {
+        simulator_stats.failed_read_count++;
+    }
+
+    return data;
+}
+
+/** \brief Account a write transaction and get the host address of the written area */
+static U8* SIMULATOR_write(const U32 address, const U32 size)
+{
+    U8* const data = SIMULATOR_map(address, size);
+
+    SIMULATOR_transaction(size);
+    simulator_stats.write_count++;
+    if (data != NULL)
+    {
+        simulator_stats.write_bytes += size;
+    }
+
+    return data;
+}
+
+/** \brief Display a plugin message */
+static void SIMULATOR_output(const char* const level, const char* const format, va_list args)
+{
+    if (simulator_verbose)
+    {
+        printf("[%s] ", level);
+        vprintf(format, args);
+        printf("\n");
+    }
+}
+
+
+/** \brief GDB_API::pfFree */
+static void SIMULATOR_Free(void* p)
+{
+    free(p);
+}
+
+/** \brief GDB_API::pfAlloc */
+static void* SIMULATOR_Alloc(unsigned Size)
+{
+    return malloc(Size);
+}
+
+/** \brief GDB_API::pfRealloc */
+static void* SIMULATOR_Realloc(void* p, unsigned Size)
+{
+    return realloc(p, Size);
+}
+
+/** \brief GDB_API::pfLogOutf */
+static void SIMULATOR_LogOutf(const char* sFormat, ...)
+{
+    va_list args;
+    va_start(args, sFormat);
+    SIMULATOR_output("log", sFormat, args);
+    va_end(args);
+}
+
+/** \brief GDB_API::pfDebugOutf */
+static void SIMULATOR_DebugOutf(const char* sFormat, ...)
+{
+    va_list args;
+    va_start(args, sFormat);
+    SIMULATOR_output("debug", sFormat, args);
+    va_end(args);
+}
+
+/** \brief GDB_API::pfWarnOutf */
+static void SIMULATOR_WarnOutf(const char* sFormat, ...)
+{
+    va_list args;
+    simulator_stats.error_count++;
+    va_start(args, sFormat);
+    SIMULATOR_output("warning", sFormat, args);
+    va_end(args);
+}
+
+/** \brief GDB_API::pfErrorOutf */
+static void SIMULATOR_ErrorOutf(const char* sFormat, ...)
+{
+    va_list args;
+    simulator_stats.error_count++;
+    va_start(args, sFormat);
+    SIMULATOR_output("error", sFormat, args);
+    va_end(args);
+}
+
+/** \brief GDB_API::pfReadMem (returns the number of bytes read, 0 on failure) */
+static int SIMULATOR_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    int ret = 0;
+    const U8* const data = SIMULATOR_read(Addr, NumBytes);
+    if (data != NULL)
+    {
+        memcpy(pData, data, NumBytes);
+        ret = (int)NumBytes;
+    }
+    return ret;
+}
+
+/** \brief GDB_API::pfReadU8 (returns 0 on success) */
+static char SIMULATOR_ReadU8(U32 Addr, U8* pData)
+{
+    char ret = -1;
+    const U8* const data = SIMULATOR_read(Addr, sizeof(U8));
+    if (data != NULL)
+    {
+        (*pData) = data[0u];
+        ret = 0;
+    }
+    return ret;
+}
+
+/** \brief GDB_API::pfReadU16 (returns 0 on success) */
+static char SIMULATOR_ReadU16(U32 Addr, U16* pData)
+{
+    char ret = -1;
+    const U8* const data = SIMULATOR_read(Addr, sizeof(U16));
+    if (data != NULL)
+    {
+        (*pData) = (U16)(data[0u] | (data[1u] << 8u));
+        ret = 0;
+    }
+    return ret;
+}
+
+/** \brief GDB_API::pfReadU32 (returns 0 on success) */
+static char SIMULATOR_ReadU32(U32 Addr, U32* pData)
+{
+    char ret = -1;
+    const U8* const data = SIMULATOR_read(Addr, sizeof(U32));
+    if (data != NULL)
+    {
+        (*pData) = ((U32)data[0u]) | (((U32)data[1u]) << 8u) | (((U32)data[2u]) << 16u) | (((U32)data[3u]) << 24u);
+        ret = 0;
+    }
+    return ret;
+}
+
+/** \brief GDB_API::pfWriteMem (returns the number of bytes written, 0 on failure) */
+static int SIMULATOR_WriteMem(U32 Addr, const char* pData, unsigned NumBytes)
+{
+    int ret = 0;
+    U8* const data = SIMULATOR_write(Addr, NumBytes);
+    if (data != NULL)
+    {
+        memcpy(data, pData, NumBytes);
+        ret = (int)NumBytes;
+    }
+    return ret;
+}
+
+/** \brief GDB_API::pfWriteU8 */
+static void SIMULATOR_WriteU8(U32 Addr, U8 Data)
+{
+    U8* const data = SIMULATOR_write(Addr, sizeof(U8));
+    if (data != NULL)
+    {
+        data[0u] = Data;
+    }
+}
+
+/** \brief GDB_API::pfWriteU16 */
+static void SIMULATOR_WriteU16(U32 Addr, U16 Data)
+{
+    U8* const data = SIMULATOR_write(Addr, sizeof(U16));
+    if (data != NULL)
+    {
+        data[0u] = (U8)(Data);
+        data[1u] = (U8)(Data >> 8u);
+    }
+}
+
+/** \brief GDB_API::pfWriteU32 */
+static void SIMULATOR_WriteU32(U32 Addr, U32 Data)
+{
+    U8* const data = SIMULATOR_write(Addr, sizeof(U32));
+    if (data != NULL)
+    {
+        data[0u] = (U8)(Data);
+        data[1u] = (U8)(Data >> 8u);
+        data[2u] = (U8)(Data >> 16u);
+        data[3u] = (U8)(Data >> 24u);
+    }
+}
+
+/** \brief GDB_API::pfLoad16TE (the simulated target is little endian) */
+static U32 SIMULATOR_Load16TE(const U8* p)
+{
+    return ((U32)p[0u]) | (((U32)p[1u]) << 8u);
+}
+
+/** \brief GDB_API::pfLoad24TE (the simulated target is little endian) */
+static U32 SIMULATOR_Load24TE(const U8* p)
+{
+    return ((U32)p[0u]) | (((U32)p[1u]) << 8u) | (((U32)p[2u]) << 16u);
+}
+
+/** \brief GDB_API::pfLoad32TE (the simulated target is little endian) */
+static U32 SIMULATOR_Load32TE(const U8* p)
+{
+    return ((U32)p[0u]) | (((U32)p[1u]) << 8u) | (((U32)p[2u]) << 16u) | (((U32)p[3u]) << 24u);
+}
+
+
+/** \brief GDB server API implemented by the simulated target */
+static const GDB_API simulator_api = {
+                                        SIMULATOR_Free,
+                                        SIMULATOR_Alloc,
+                                        SIMULATOR_Realloc,
+
+                                        SIMULATOR_LogOutf,
+                                        SIMULATOR_DebugOutf,
+                                        SIMULATOR_WarnOutf,
+                                        SIMULATOR_ErrorOutf,
+
+                                        SIMULATOR_ReadMem,
+                                        SIMULATOR_ReadU8,
+                                        SIMULATOR_ReadU16,
+                                        SIMULATOR_ReadU32,
+
+                                        SIMULATOR_WriteMem,
+                                        SIMULATOR_WriteU8,
+                                        SIMULATOR_WriteU16,
+                                        SIMULATOR_WriteU32,
+
+                                        SIMULATOR_Load16TE,
+                                        SIMULATOR_Load24TE,
+                                        SIMULATOR_Load32TE
+                                     };
+
+
+
+/** \brief Initialize an empty simulated target with the given link model (NULL for the default one),
+           the plugin messages are displayed only in verbose mode */
+void SIMULATOR_init(const simulator_link_model_t* const link_model, const bool verbose)
+{
+    SIMULATOR_release();
+
+    if (link_model != NULL)
+    {
+        simulator_link_model = (*link_model);
+    }
+    else
+    {
+        simulator_link_model.transaction_latency_ns = SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS;
+        simulator_link_model.byte_cost_ns = SIMULATOR_DEFAULT_BYTE_COST_NS;
+    }
+    simulator_verbose = verbose;
+    simulator_memory_handler = NULL;
+    SIMULATOR_resetStats();
+}
+
+/** \brief Release all the memory regions of the simulated target */
+void SIMULATOR_release(void)
+{
+    U32 i;
+    for (i = 0u; i < simulator_region_count; i++)
+    {
+        free(simulator_regions[i].data);
+    }
+    memset(simulator_regions, 0, sizeof(simulator_regions));
+    simulator_region_count = 0u;
+}
+
+/** \brief Add a zero filled memory region to the simulated target, returns its host address or NULL on failure */
+U8* SIMULATOR_addRegion(const U32 address, const U32 size)
+{
+    U8* ret = NULL;
+
+    /* Regions must not wrap around the address space */
+    if ((simulator_region_count < SIMULATOR_MAX_REGIONS) && (size != 0u) && ((address + size - 1u) >= address))
+    {
+        ret = (U8*)calloc(size, sizeof(U8));
+        if (ret != NULL)
+        {
+            simulator_region_t* const region = &simulator_regions[simulator_region_count];
+            region->address = address;
+            region->size = size;
+            region->data = ret;
+            simulator_region_count++;
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Get the host address of a target memory area, returns NULL if the area is not fully mapped */
+U8* SIMULATOR_map(const U32 address, const U32 size)
+{
+    U32 i;
+    U8* ret = NULL;
+
+    if (simulator_memory_handler != NULL)
+    {
+        ret = simulator_memory_handler(address, size);
+    }
+    for (i = 0u; (i < simulator_region_count) && (ret == NULL) && (simulator_memory_handler == NULL); i++)
+    {
+        const simulator_region_t* const region = &simulator_regions[i];
+        if ((address >= region->address) &&
+            ((address - region->address) <= region->size) &&
+            (size <= (region->size - (address - region->address))))
+        {
+            ret = &region->data[address - region->address];
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Serve the target memory with the given handler instead of the memory regions (NULL to use the regions) */
+void SIMULATOR_setMemoryHandler(const fp_simulator_memory_handler_t handler)
+{
+    simulator_memory_handler = handler;
+}
+
+/** \brief Get the GDB server API implemented by the simulated target */
+const GDB_API* SIMULATOR_getApi(void)
+{
+    return &simulator_api;
+}
+
+/** \brief Get the probe activity counters since the last reset */
+void SIMULATOR_getStats(simulator_stats_t* const stats)
+{
+    (*stats) = simulator_stats;
+}
+
+/** \brief Reset the probe activity counters */
+void SIMULATOR_resetStats(void)
+{
+    memset(&simulator_stats, 0, sizeof(simulator_stats));
+}
+
+/** \brief Write an 8 bits value in the target memory without probe cost */
+bool SIMULATOR_poke8(const U32 address, const U8 value)
+{
+    bool ret = false;
+    U8* const data = SIMULATOR_map(address, sizeof(U8));
+    if (data != NULL)
+    {
+        data[0u] = value;
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Write a 16 bits value in the target memory without probe cost */
+bool SIMULATOR_poke16(const U32 address, const U16 value)
+{
+    bool ret = false;
+    U8* const data = SIMULATOR_map(address, sizeof(U16));
+    if (data != NULL)
+    {
+        data[0u] = (U8)(value);
+        data[1u] = (U8)(value >> 8u);
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Write a 32 bits value in the target memory without probe cost */
+bool SIMULATOR_poke32(const U32 address, const U32 value)
+{
+    bool ret = false;
+    U8* const data = SIMULATOR_map(address, sizeof(U32));
+    if (data != NULL)
+    {
+        data[0u] = (U8)(value);
+        data[1u] = (U8)(value >> 8u);
+        data[2u] = (U8)(value >> 16u);
+        data[3u] = (U8)(value >> 24u);
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Write a null terminated string in the target memory without probe cost */
+bool SIMULATOR_pokeString(const U32 address, const char* const value)
+{
+    bool ret = false;
+    const U32 size = (U32)(strlen(value) + 1u);
+    U8* const data = SIMULATOR_map(address, size);
+    if (data != NULL)
+    {
+        memcpy(data, value, size);
+        ret = true;
+    }
+    return ret;
+}
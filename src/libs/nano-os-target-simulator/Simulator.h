@@ -0,0 +1,109 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "RTOSPlugin.h"
+
+#include <stdbool.h>
+
+
+/** \brief Maximum number of memory regions in the simulated target */
+#define SIMULATOR_MAX_REGIONS   8u
+
+/** \brief Default probe transaction latency in ns (typical J-Link USB round trip) */
+#define SIMULATOR_DEFAULT_TRANSACTION_LATENCY_NS    125000u
+
+/** \brief Default probe cost per transferred byte in ns (about 2MB/s of SWD throughput) */
+#define SIMULATOR_DEFAULT_BYTE_COST_NS              500u
+
+
+/** \brief Probe link cost model */
+typedef struct _simulator_link_model_t
+{
+    /** \brief Fixed cost of a probe transaction in ns */
+    U32 transaction_latency_ns;
+    /** \brief Cost of each transferred byte in ns */
+    U32 byte_cost_ns;
+} simulator_link_model_t;
+
+/** \brief Probe activity counters */
+typedef struct _simulator_stats_t
+{
+    /** \brief Number of read transactions */
+    U32 read_count;
+    /** \brief Number of read transactions which failed */
+    U32 failed_read_count;
+    /** \brief Number of bytes read */
+    U64 read_bytes;
+    /** \brief Number of write transactions */
+    U32 write_count;
+    /** \brief Number of bytes written */
+    U64 write_bytes;
+    /** \brief Number of warning and error messages emitted by the plugin */
+    U32 error_count;
+    /** \brief Modeled time spent on the probe link in ns */
+    U64 link_time_ns;
+} simulator_stats_t;
+
+/** \brief Function serving the target memory instead of the memory regions, returns the host address
+           of the area or NULL if the area is not accessible */
+typedef U8* (*fp_simulator_memory_handler_t)(const U32 address, const U32 size);
+
+
+/** \brief Initialize an empty simulated target with the given link model (NULL for the default one),
+           the plugin messages are displayed only in verbose mode */
+void SIMULATOR_init(const simulator_link_model_t* const link_model, const bool verbose);
+
+/** \brief Release all the memory regions of the simulated target */
+void SIMULATOR_release(void);
+
+/** \brief Add a zero filled memory region to the simulated target, returns its host address or NULL on failure */
+U8* SIMULATOR_addRegion(const U32 address, const U32 size);
+
+/** \brief Get the host address of a target memory area, returns NULL if the area is not fully mapped */
+U8* SIMULATOR_map(const U32 address, const U32 size);
+
+/** \brief Serve the target memory with the given handler instead of the memory regions (NULL to use the regions) */
+void SIMULATOR_setMemoryHandler(const fp_simulator_memory_handler_t handler);
+
+/** \brief Get the GDB server API implemented by the simulated target */
+const GDB_API* SIMULATOR_getApi(void);
+
+/** \brief Get the probe activity counters since the last reset */
+void SIMULATOR_getStats(simulator_stats_t* const stats);
+
+/** \brief Reset the probe activity counters */
+void SIMULATOR_resetStats(void);
+
+/** \brief Write an 8 bits value in the target memory without probe cost */
+bool SIMULATOR_poke8(const U32 address, const U8 value);
+
+/** \brief Write a 16 bits value in the target memory without probe cost */
+bool SIMULATOR_poke16(const U32 address, const U16 value);
+
+/** \brief Write a 32 bits value in the target memory without probe cost */
+bool SIMULATOR_poke32(const U32 address, const U32 value);
+
+/** \brief Write a null terminated string in the target memory without probe cost */
+bool SIMULATOR_pokeString(const U32 address, const char* const value);
+
+
+#endif /* SIMULATOR_H */
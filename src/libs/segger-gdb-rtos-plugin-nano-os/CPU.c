@@ -32,8 +32,8 @@ U32 CPU_computeStackFrameSize(const nano_os_cpu_register_set_t* const cpu_reg_se
     const nano_os_cpu_reg_t* cpu_reg = cpu_reg_set->registers;
     while (cpu_reg->name != NULL)
     {
-        /* Compute size only for stacked registers */
-        if (cpu_reg->stack_offset > 0)
+        /* Compute size only for stacked registers (the first one is at offset 0) */
+        if (cpu_reg->stack_offset >= 0)
         {
             stack_frame_size += cpu_reg->size;
         }
@@ -57,8 +57,8 @@ typedef struct _nano_os_cpu_register_set_t
     U32 output_reg_count;
 } nano_os_cpu_register_set_t;
 
-/** \brief Function which retrieve a set of CPU registers */
-typedef const nano_os_cpu_register_set_t* (*fp_cpu_registers_get)(const GDB_API* gdb_api, const char* const port_name, const U32 task_port_data_address);
+/** \brief Function which retrieve the set of CPU registers of a task from its port specific data (NULL if the port doesn't use it) */
+typedef const nano_os_cpu_register_set_t* (*fp_cpu_registers_get)(const char* const port_name, const U8* const task_port_data);
 
 /** \brief Description of a CPU port */
 typedef struct _nano_os_cpu_port_t
@@ -69,6 +69,8 @@ typedef struct _nano_os_cpu_port_t
     const char* cpu_name;
     /** \brief Stack growth direction */
     I8 stack_growth_dir;
+    /** \brief Size in bytes of the port specific data of a task needed to retrieve its set of CPU registers */
+    U8 task_port_data_size;
     /** \brief Function which retrieve the set of CPU registers */
     fp_cpu_registers_get registers_get;
 } nano_os_cpu_port_t;
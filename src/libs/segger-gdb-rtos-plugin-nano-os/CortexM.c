@@ -194,10 +194,9 @@ static const nano_os_cpu_register_set_t cortex_m_vfp_register_set = { cortex_m_v
 
 
 /** \brief Function which retrieve the set of CPU registers for Cortex-M0 */
-static const nano_os_cpu_register_set_t* CORTEXM0_CpuRegistersGet(const GDB_API* gdb_api, const char* const port_name, const U32 task_port_data_address)
+static const nano_os_cpu_register_set_t* CORTEXM0_CpuRegistersGet(const char* const port_name, const U8* const task_port_data)
 {
-    (void)gdb_api;
-    (void)task_port_data_address;
+    (void)task_port_data;
     const nano_os_cpu_register_set_t* ret = &cortex_m0_register_set;
     if (strcmp(port_name, "cortex-m0+") == 0)
     {
@@ -207,26 +206,23 @@ static const nano_os_cpu_register_set_t* CORTEXM0_CpuRegistersGet(const GDB_API*
 }
 
 /** \brief Function which retrieve the set of CPU registers for Cortex-M3 */
-static const nano_os_cpu_register_set_t* CORTEXM3_CpuRegistersGet(const GDB_API* gdb_api, const char* const port_name, const U32 task_port_data_address)
+static const nano_os_cpu_register_set_t* CORTEXM3_CpuRegistersGet(const char* const port_name, const U8* const task_port_data)
 {
-    (void)gdb_api;
     (void)port_name;
-    (void)task_port_data_address;
+    (void)task_port_data;
     return &cortex_m_register_set;
 }
 
 /** \brief Function which retrieve the set of CPU registers for Cortex-Mx with VFP */
-static const nano_os_cpu_register_set_t* CORTEXMxVFP_CpuRegistersGet(const GDB_API* gdb_api, const char* const port_name, const U32 task_port_data_address)
+static const nano_os_cpu_register_set_t* CORTEXMxVFP_CpuRegistersGet(const char* const port_name, const U8* const task_port_data)
 {
-    U8 use_float;
     (void)port_name;
     const nano_os_cpu_register_set_t* ret = NULL;
 
-    /* Read the floating point usage flag */
-    const int err = gdb_api->pfReadU8(task_port_data_address, &use_float);
-    if (err == 0u)
+    /* Check the floating point usage flag */
+    if (task_port_data != NULL)
     {
-        if (use_float == 0u)
+        if (task_port_data[0u] == 0u)
         {
             ret = &cortex_m_register_set;
         }
@@ -244,16 +240,16 @@ static const nano_os_cpu_register_set_t* CORTEXMxVFP_CpuRegistersGet(const GDB_A
 
 /** \brief Supported Cortex-M cores */
 const nano_os_cpu_port_t g_cortex_m_cores[] = {
-                                                { JLINK_CORE_CORTEX_M0, "cortex-m0", DESCENDING_STACK, CORTEXM0_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M1, "cortex-m1", DESCENDING_STACK, CORTEXM0_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M3, "cortex-m3", DESCENDING_STACK, CORTEXM3_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M3_R1P0, "cortex-m3", DESCENDING_STACK, CORTEXM3_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M3_R1P1, "cortex-m3", DESCENDING_STACK, CORTEXM3_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M3_R2P0, "cortex-m3", DESCENDING_STACK, CORTEXM3_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M4, "cortex-m4", DESCENDING_STACK, CORTEXMxVFP_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M7, "cortex-m7", DESCENDING_STACK, CORTEXMxVFP_CpuRegistersGet },
-                                                { JLINK_CORE_CORTEX_M_V8MAINL, "cortex-m_v8", DESCENDING_STACK, CORTEXMxVFP_CpuRegistersGet },
-                                                {0u, NULL, DESCENDING_STACK, NULL }
+                                                { JLINK_CORE_CORTEX_M0, "cortex-m0", DESCENDING_STACK, 0u, CORTEXM0_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M1, "cortex-m1", DESCENDING_STACK, 0u, CORTEXM0_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M3, "cortex-m3", DESCENDING_STACK, 0u, CORTEXM3_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M3_R1P0, "cortex-m3", DESCENDING_STACK, 0u, CORTEXM3_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M3_R1P1, "cortex-m3", DESCENDING_STACK, 0u, CORTEXM3_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M3_R2P0, "cortex-m3", DESCENDING_STACK, 0u, CORTEXM3_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M4, "cortex-m4", DESCENDING_STACK, 1u, CORTEXMxVFP_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M7, "cortex-m7", DESCENDING_STACK, 1u, CORTEXMxVFP_CpuRegistersGet },
+                                                { JLINK_CORE_CORTEX_M_V8MAINL, "cortex-m_v8", DESCENDING_STACK, 1u, CORTEXMxVFP_CpuRegistersGet },
+                                                {0u, NULL, DESCENDING_STACK, 0u, NULL }
                                               };
 
 
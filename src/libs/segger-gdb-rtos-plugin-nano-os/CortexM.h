@@ -24,6 +24,6 @@ along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
 
 
 /** \brief Supported Cortex-M cores */
-const nano_os_cpu_port_t g_cortex_m_cores[];
+extern const nano_os_cpu_port_t g_cortex_m_cores[];
 
 #endif /* CORTEXM_H */
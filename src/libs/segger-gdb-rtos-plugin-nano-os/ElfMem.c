@@ -0,0 +1,393 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ElfMem.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifndef WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+
+/** \brief Size of the ELF identification */
+#define ELF_IDENT_SIZE          16u
+
+/** \brief Size of the ELF32 file header */
+#define ELF32_HEADER_SIZE       52u
+
+/** \brief Size of an ELF32 program header */
+#define ELF32_PHDR_SIZE         32u
+
+/** \brief ELF class for 32 bits files */
+#define ELF_CLASS_32            1u
+
+/** \brief ELF data encoding for little endian files */
+#define ELF_DATA_LSB            1u
+
+/** \brief ELF data encoding for big endian files */
+#define ELF_DATA_MSB            2u
+
+/** \brief Loadable program segment */
+#define ELF_PT_LOAD             1u
+
+/** \brief Writable segment flag */
+#define ELF_PF_W                2u
+
+
+/** \brief Read-only segment of the ELF file */
+typedef struct _elfmem_segment_t
+{
+    /** \brief Start address in the target memory */
+    U32 start;
+    /** \brief Size in bytes */
+    U32 size;
+    /** \brief Content in the mapped file */
+    const U8* data;
+} elfmem_segment_t;
+
+
+/** \brief GDB server API used to access the target */
+static const GDB_API* elfmem_target_api = NULL;
+
+/** \brief GDB server API serving the read-only segments from the ELF file */
+static GDB_API elfmem_api;
+
+/** \brief Mapped ELF file */
+static const U8* elfmem_file = NULL;
+
+/** \brief Size in bytes of the mapped ELF file */
+static U32 elfmem_file_size = 0u;
+
+#ifdef WIN32
+/** \brief ELF file mapping handle */
+static HANDLE elfmem_mapping = NULL;
+#endif
+
+/** \brief Read-only segments sorted by start address */
+static elfmem_segment_t elfmem_segments[ELFMEM_MAX_SEGMENTS];
+
+/** \brief Number of read-only segments */
+static U32 elfmem_segment_count = 0u;
+
+
+
+/** \brief Decode a 16 bits value from the ELF file */
+static U32 ELFMEM_load16(const U8* const p, const U8 encoding)
+{
+    U32 ret;
+    if (encoding == ELF_DATA_LSB)
+    {
+        ret = ((U32)p[0u]) | (((U32)p[1u]) << 8u);
+    }
+    else
+    {
+        ret = ((U32)p[1u]) | (((U32)p[0u]) << 8u);
+    }
+    return ret;
+}
+
+/** \brief Decode a 32 bits value from the ELF file */
+static U32 ELFMEM_load32(const U8* const p, const U8 encoding)
+{
+    U32 ret;
+    if (encoding == ELF_DATA_LSB)
+    {
+        ret = ((U32)p[0u]) | (((U32)p[1u]) << 8u) | (((U32)p[2u]) << 16u) | (((U32)p[3u]) << 24u);
+    }
+    else
+    {
+        ret = ((U32)p[3u]) | (((U32)p[2u]) << 8u) | (((U32)p[1u]) << 16u) | (((U32)p[0u]) << 24u);
+    }
+    return ret;
+}
+
+/** \brief Compare the start address of 2 segments */
+static int ELFMEM_compareSegments(const void* a, const void* b)
+{
+    const elfmem_segment_t* const segment_a = (const elfmem_segment_t*)a;
+    const elfmem_segment_t* const segment_b = (const elfmem_segment_t*)b;
+    int ret = 0;
+    if (segment_a->start < segment_b->start)
+    {
+        ret = -1;
+    }
+    else if (segment_a->start > segment_b->start)
+    {
+        ret = 1;
+    }
+    return ret;
+}
+
+/** \brief Map the ELF file in memory */
+static bool ELFMEM_mapFile(const char* const path)
+{
+    bool ret = false;
+
+#ifdef WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        elfmem_file_size = GetFileSize(file, NULL);
+        elfmem_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (elfmem_mapping != NULL)
+        {
+            elfmem_file = (const U8*)MapViewOfFile(elfmem_mapping, FILE_MAP_READ, 0, 0, 0);
+            ret = (elfmem_file != NULL);
+        }
+        CloseHandle(file);
+    }
+#else
+    const int file = open(path, O_RDONLY);
+    if (file >= 0)
+    {
+        struct stat file_stat;
+        if (fstat(file, &file_stat) == 0)
+        {
+            void* const mapping = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapping != MAP_FAILED)
+            {
+                elfmem_file = (const U8*)mapping;
+                elfmem_file_size = (U32)file_stat.st_size;
+                ret = true;
+            }
+        }
+        close(file);
+    }
+#endif
+
+    return ret;
+}
+
+/** \brief Build the index of the read-only loadable segments */
+static bool ELFMEM_indexSegments(void)
+{
+    bool ret = false;
+
+    /* Check ELF header */
+    if ((elfmem_file_size >= ELF32_HEADER_SIZE) && (memcmp(elfmem_file, "\177ELF", 4u) == 0) &&
+        (elfmem_file[4u] == ELF_CLASS_32) && ((elfmem_file[5u] == ELF_DATA_LSB) || (elfmem_file[5u] == ELF_DATA_MSB)))
+    {
+        U32 i;
+        const U8 encoding = elfmem_file[5u];
+        const U32 phoff = ELFMEM_load32(&elfmem_file[28u], encoding);
+        const U32 phentsize = ELFMEM_load16(&elfmem_file[42u], encoding);
+        const U32 phnum = ELFMEM_load16(&elfmem_file[44u], encoding);
+
+        /* Check program header table */
+        if ((phentsize >= ELF32_PHDR_SIZE) && (phoff < elfmem_file_size) && ((phnum * phentsize) <= (elfmem_file_size - phoff)))
+        {
+            /* Go through all the program headers */
+            elfmem_segment_count = 0u;
+            for (i = 0; (i < phnum) && (elfmem_segment_count < ELFMEM_MAX_SEGMENTS); i++)
+            {
+                const U8* const phdr = &elfmem_file[phoff + i * phentsize];
+                const U32 type = ELFMEM_load32(&phdr[0u], encoding);
+                const U32 offset = ELFMEM_load32(&phdr[4u], encoding);
+                const U32 vaddr = ELFMEM_load32(&phdr[8u], encoding);
+                const U32 filesz = ELFMEM_load32(&phdr[16u], encoding);
+                const U32 flags = ELFMEM_load32(&phdr[24u], encoding);
+
+                /* Keep only read-only loadable segments which are fully inside the file */
+                if ((type == ELF_PT_LOAD) && ((flags & ELF_PF_W) == 0u) && (filesz != 0u) &&
+                    (offset < elfmem_file_size) && (filesz <= (elfmem_file_size - offset)))
+                {
+                    elfmem_segment_t* const segment = &elfmem_segments[elfmem_segment_count];
+                    segment->start = vaddr;
+                    segment->size = filesz;
+                    segment->data = &elfmem_file[offset];
+                    elfmem_segment_count++;
+                }
+            }
+
+            /* Sort the segments for the lookups */
+            qsort(elfmem_segments, elfmem_segment_count, sizeof(elfmem_segment_t), ELFMEM_compareSegments);
+            ret = (elfmem_segment_count != 0u);
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Get the content of a target memory area if it is fully inside a read-only segment */
+static const U8* ELFMEM_find(const U32 address, const U32 size)
+{
+    const U8* ret = NULL;
+    U32 first = 0u;
+    U32 last = elfmem_segment_count;
+
+    /* Binary search of the last segment starting before the address */
+    while (first < last)
+    {
+        const U32 middle = (first + last) / 2u;
+        if (elfmem_segments[middle].start <= address)
+        {
+            first = middle + 1u;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    if (first != 0u)
+    {
+        const elfmem_segment_t* const segment = &elfmem_segments[first - 1u];
+        const U32 offset = address - segment->start;
+        if ((offset < segment->size) && (size <= (segment->size - offset)))
+        {
+            ret = &segment->data[offset];
+        }
+    }
+
+    return ret;
+}
+
+
+/** \brief ELF backed version of GDB_API::pfReadMem */
+static int ELFMEM_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    int ret;
+    const U8* const data = ELFMEM_find(Addr, NumBytes);
+    if (data != NULL)
+    {
+        memcpy(pData, data, NumBytes);
+        ret = (int)NumBytes;
+    }
+    else
+    {
+        ret = elfmem_target_api->pfReadMem(Addr, pData, NumBytes);
+    }
+    return ret;
+}
+
+/** \brief ELF backed version of GDB_API::pfReadU8 */
+static char ELFMEM_ReadU8(U32 Addr, U8* pData)
+{
+    char ret;
+    const U8* const data = ELFMEM_find(Addr, 1u);
+    if (data != NULL)
+    {
+        (*pData) = (*data);
+        ret = 0;
+    }
+    else
+    {
+        ret = elfmem_target_api->pfReadU8(Addr, pData);
+    }
+    return ret;
+}
+
+/** \brief ELF backed version of GDB_API::pfReadU16 */
+static char ELFMEM_ReadU16(U32 Addr, U16* pData)
+{
+    char ret;
+    const U8* const data = ELFMEM_find(Addr, 2u);
+    if (data != NULL)
+    {
+        (*pData) = (U16)elfmem_target_api->pfLoad16TE(data);
+        ret = 0;
+    }
+    else
+    {
+        ret = elfmem_target_api->pfReadU16(Addr, pData);
+    }
+    return ret;
+}
+
+/** \brief ELF backed version of GDB_API::pfReadU32 */
+static char ELFMEM_ReadU32(U32 Addr, U32* pData)
+{
+    char ret;
+    const U8* const data = ELFMEM_find(Addr, 4u);
+    if (data != NULL)
+    {
+        (*pData) = elfmem_target_api->pfLoad32TE(data);
+        ret = 0;
+    }
+    else
+    {
+        ret = elfmem_target_api->pfReadU32(Addr, pData);
+    }
+    return ret;
+}
+
+
+
+/** \brief Open the firmware ELF file if configured and get the API serving its read-only segments
+           (the given API is returned as is if no ELF file is available) */
+const GDB_API* ELFMEM_init(const GDB_API* const target_api)
+{
+    const GDB_API* ret = target_api;
+    const char* const path = getenv(ELFMEM_FILE_ENV_VAR);
+
+    /* Release the previously opened file */
+    ELFMEM_close();
+
+    /* Check if an ELF file has been configured */
+    if ((path != NULL) && (path[0u] != 0))
+    {
+        if (ELFMEM_mapFile(path) && ELFMEM_indexSegments())
+        {
+            /* Build the ELF backed API */
+            elfmem_target_api = target_api;
+            elfmem_api = (*target_api);
+            elfmem_api.pfReadMem = ELFMEM_ReadMem;
+            elfmem_api.pfReadU8 = ELFMEM_ReadU8;
+            elfmem_api.pfReadU16 = ELFMEM_ReadU16;
+            elfmem_api.pfReadU32 = ELFMEM_ReadU32;
+            ret = &elfmem_api;
+
+            target_api->pfLogOutf("Nano-OS plugin: serving %u read-only segments from %s\n", elfmem_segment_count, path);
+        }
+        else
+        {
+            target_api->pfWarnOutf("Nano-OS plugin: unable to use ELF file %s\n", path);
+            ELFMEM_close();
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Release the firmware ELF file */
+void ELFMEM_close(void)
+{
+    if (elfmem_file != NULL)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(elfmem_file);
+#else
+        munmap((void*)elfmem_file, elfmem_file_size);
+#endif
+    }
+#ifdef WIN32
+    if (elfmem_mapping != NULL)
+    {
+        CloseHandle(elfmem_mapping);
+        elfmem_mapping = NULL;
+    }
+#endif
+    elfmem_file = NULL;
+    elfmem_file_size = 0u;
+    elfmem_segment_count = 0u;
+}
@@ -0,0 +1,42 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ELFMEM_H
+#define ELFMEM_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Name of the environment variable containing the path to the firmware ELF file */
+#define ELFMEM_FILE_ENV_VAR     "NANO_OS_PLUGIN_ELF_FILE"
+
+/** \brief Maximum number of read-only segments served from the ELF file */
+#define ELFMEM_MAX_SEGMENTS     32u
+
+
+
+/** \brief Open the firmware ELF file if configured and get the API serving its read-only segments
+           (the given API is returned as is if no ELF file is available) */
+const GDB_API* ELFMEM_init(const GDB_API* const target_api);
+
+/** \brief Release the firmware ELF file */
+void ELFMEM_close(void);
+
+
+#endif /* ELFMEM_H */
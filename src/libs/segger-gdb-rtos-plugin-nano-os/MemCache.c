@@ -0,0 +1,279 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MemCache.h"
+
+#include <stdbool.h>
+
+
+/** \brief Cached target memory page */
+typedef struct _memcache_page_t
+{
+    /** \brief Target address of the page */
+    U32 address;
+    /** \brief Cache generation in which the page has been loaded */
+    U32 generation;
+    /** \brief Page content */
+    U8 data[MEMCACHE_PAGE_SIZE];
+} memcache_page_t;
+
+
+/** \brief GDB server API used to access the target */
+static const GDB_API* memcache_target_api = NULL;
+
+/** \brief GDB server API served through the cache */
+static GDB_API memcache_api;
+
+/** \brief Current cache generation, pages from older generations are invalid */
+static U32 memcache_generation;
+
+/** \brief Cached pages (direct mapped on the page number) */
+static memcache_page_t memcache_pages[MEMCACHE_PAGE_COUNT];
+
+/** \brief Buffer for fetching consecutive missing pages */
+static U8 memcache_fetch_buffer[MEMCACHE_MAX_FETCH_PAGES * MEMCACHE_PAGE_SIZE];
+
+
+
+/** \brief Get the cache slot of a page */
+static memcache_page_t* MEMCACHE_getSlot(const U32 page_address)
+{
+    return &memcache_pages[(page_address / MEMCACHE_PAGE_SIZE) % MEMCACHE_PAGE_COUNT];
+}
+
+/** \brief Look for a page in the cache */
+static memcache_page_t* MEMCACHE_findPage(const U32 page_address)
+{
+    memcache_page_t* page = MEMCACHE_getSlot(page_address);
+    if ((page->generation != memcache_generation) || (page->address != page_address))
+    {
+        page = NULL;
+    }
+    return page;
+}
+
+/** \brief Fetch a run of consecutive missing pages from the target */
+static bool MEMCACHE_fetchPages(const U32 first_page_address, const U32 page_count)
+{
+    U32 i;
+    bool ret = false;
+
+    /* Read all the pages at once */
+    const int err = memcache_target_api->pfReadMem(first_page_address, (char*)memcache_fetch_buffer, page_count * MEMCACHE_PAGE_SIZE);
+    if (err != 0)
+    {
+        /* Store the pages */
+        for (i = 0; i < page_count; i++)
+        {
+            const U32 page_address = first_page_address + i * MEMCACHE_PAGE_SIZE;
+            memcache_page_t* const page = MEMCACHE_getSlot(page_address);
+            memcpy(page->data, &memcache_fetch_buffer[i * MEMCACHE_PAGE_SIZE], MEMCACHE_PAGE_SIZE);
+            page->address = page_address;
+            page->generation = memcache_generation;
+        }
+        ret = true;
+    }
+
+    return ret;
+}
+
+/** \brief Read target memory through the cache */
+static bool MEMCACHE_read(const U32 address, U8* const data, const U32 size)
+{
+    bool ret = true;
+    U32 offset = 0u;
+
+    /* Go through all the pages covered by the requested area */
+    while (ret && (offset < size))
+    {
+        const U32 current_address = address + offset;
+        const U32 page_address = current_address - (current_address % MEMCACHE_PAGE_SIZE);
+        const U32 page_offset = current_address - page_address;
+        U32 chunk_size = MEMCACHE_PAGE_SIZE - page_offset;
+        if (chunk_size > (size - offset))
+        {
+            chunk_size = size - offset;
+        }
+
+        /* Check if the page is already in the cache */
+        memcache_page_t* page = MEMCACHE_findPage(page_address);
+        if (page == NULL)
+        {
+            /* Count the consecutive missing pages needed by the request */
+            const U32 last_address = address + size - 1u;
+            const U32 last_page_address = last_address - (last_address % MEMCACHE_PAGE_SIZE);
+            U32 page_count = 1u;
+            while ((page_count < MEMCACHE_MAX_FETCH_PAGES) &&
+                   ((page_address + page_count * MEMCACHE_PAGE_SIZE) <= last_page_address) &&
+                   (MEMCACHE_findPage(page_address + page_count * MEMCACHE_PAGE_SIZE) == NULL))
+            {
+                page_count++;
+            }
+
+            /* Fetch them */
+            if (MEMCACHE_fetchPages(page_address, page_count))
+            {
+                page = MEMCACHE_getSlot(page_address);
+            }
+        }
+        if (page != NULL)
+        {
+            memcpy(&data[offset], &page->data[page_offset], chunk_size);
+        }
+        else
+        {
+            /* The whole page is not readable (end of a memory area), read only the requested bytes */
+            const int err = memcache_target_api->pfReadMem(current_address, (char*)&data[offset], chunk_size);
+            ret = (err != 0);
+        }
+
+        /* Next page */
+        offset += chunk_size;
+    }
+
+    return ret;
+}
+
+/** \brief Invalidate the cached pages overlapping a target memory area */
+static void MEMCACHE_invalidateArea(const U32 address, const U32 size)
+{
+    U32 page_address = address - (address % MEMCACHE_PAGE_SIZE);
+    while (page_address < (address + size))
+    {
+        memcache_page_t* const page = MEMCACHE_findPage(page_address);
+        if (page != NULL)
+        {
+            page->generation = 0u;
+        }
+        page_address += MEMCACHE_PAGE_SIZE;
+    }
+}
+
+
+/** \brief Cached version of GDB_API::pfReadMem */
+static int MEMCACHE_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    int ret = 0;
+    if (MEMCACHE_read(Addr, (U8*)pData, NumBytes))
+    {
+        ret = (int)NumBytes;
+    }
+    return ret;
+}
+
+/** \brief Cached version of GDB_API::pfReadU8 */
+static char MEMCACHE_ReadU8(U32 Addr, U8* pData)
+{
+    char ret = -1;
+    if (MEMCACHE_read(Addr, pData, 1u))
+    {
+        ret = 0;
+    }
+    return ret;
+}
+
+/** \brief Cached version of GDB_API::pfReadU16 */
+static char MEMCACHE_ReadU16(U32 Addr, U16* pData)
+{
+    U8 data[2u];
+    char ret = -1;
+    if (MEMCACHE_read(Addr, data, sizeof(data)))
+    {
+        (*pData) = (U16)memcache_target_api->pfLoad16TE(data);
+        ret = 0;
+    }
+    return ret;
+}
+
+/** \brief Cached version of GDB_API::pfReadU32 */
+static char MEMCACHE_ReadU32(U32 Addr, U32* pData)
+{
+    U8 data[4u];
+    char ret = -1;
+    if (MEMCACHE_read(Addr, data, sizeof(data)))
+    {
+        (*pData) = memcache_target_api->pfLoad32TE(data);
+        ret = 0;
+    }
+    return ret;
+}
+
+/** \brief Write through version of GDB_API::pfWriteMem */
+static int MEMCACHE_WriteMem(U32 Addr, const char* pData, unsigned NumBytes)
+{
+    MEMCACHE_invalidateArea(Addr, NumBytes);
+    return memcache_target_api->pfWriteMem(Addr, pData, NumBytes);
+}
+
+/** \brief Write through version of GDB_API::pfWriteU8 */
+static void MEMCACHE_WriteU8(U32 Addr, U8 Data)
+{
+    MEMCACHE_invalidateArea(Addr, 1u);
+    memcache_target_api->pfWriteU8(Addr, Data);
+}
+
+/** \brief Write through version of GDB_API::pfWriteU16 */
+static void MEMCACHE_WriteU16(U32 Addr, U16 Data)
+{
+    MEMCACHE_invalidateArea(Addr, 2u);
+    memcache_target_api->pfWriteU16(Addr, Data);
+}
+
+/** \brief Write through version of GDB_API::pfWriteU32 */
+static void MEMCACHE_WriteU32(U32 Addr, U32 Data)
+{
+    MEMCACHE_invalidateArea(Addr, 4u);
+    memcache_target_api->pfWriteU32(Addr, Data);
+}
+
+
+
+/** \brief Initialize the target memory cache on top of the GDB server API and get the cached API */
+const GDB_API* MEMCACHE_init(const GDB_API* const target_api)
+{
+    /* Build the cached API from the GDB server API */
+    memcache_target_api = target_api;
+    memcache_api = (*target_api);
+    memcache_api.pfReadMem = MEMCACHE_ReadMem;
+    memcache_api.pfReadU8 = MEMCACHE_ReadU8;
+    memcache_api.pfReadU16 = MEMCACHE_ReadU16;
+    memcache_api.pfReadU32 = MEMCACHE_ReadU32;
+    memcache_api.pfWriteMem = MEMCACHE_WriteMem;
+    memcache_api.pfWriteU8 = MEMCACHE_WriteU8;
+    memcache_api.pfWriteU16 = MEMCACHE_WriteU16;
+    memcache_api.pfWriteU32 = MEMCACHE_WriteU32;
+
+    /* Empty cache */
+    memset(memcache_pages, 0, sizeof(memcache_pages));
+    memcache_generation = 1u;
+
+    return &memcache_api;
+}
+
+/** \brief Invalidate all the cached target memory pages */
+void MEMCACHE_invalidate(void)
+{
+    /* Pages from the previous generations are not valid anymore */
+    memcache_generation++;
+    if (memcache_generation == 0u)
+    {
+        memset(memcache_pages, 0, sizeof(memcache_pages));
+        memcache_generation = 1u;
+    }
+}
@@ -0,0 +1,44 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMCACHE_H
+#define MEMCACHE_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Size in bytes of a cached target memory page */
+#define MEMCACHE_PAGE_SIZE          256u
+
+/** \brief Number of cached target memory pages (bounds the cache size) */
+#define MEMCACHE_PAGE_COUNT         256u
+
+/** \brief Maximum number of consecutive missing pages fetched in a single target read */
+#define MEMCACHE_MAX_FETCH_PAGES    16u
+
+
+
+/** \brief Initialize the target memory cache on top of the GDB server API and get the cached API */
+const GDB_API* MEMCACHE_init(const GDB_API* const target_api);
+
+/** \brief Invalidate all the cached target memory pages */
+void MEMCACHE_invalidate(void);
+
+
+#endif /* MEMCACHE_H */
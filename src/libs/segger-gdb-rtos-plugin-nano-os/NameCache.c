@@ -0,0 +1,170 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "NameCache.h"
+
+
+/** \brief Cached name */
+typedef struct _namecache_entry_t
+{
+    /** \brief Target address of the name content */
+    U32 address;
+    /** \brief Cache generation in which the name has been read */
+    U32 generation;
+    /** \brief Handle of the name in the string pool */
+    U32 name;
+    /** \brief Number of first bytes of the name which have been kept */
+    U32 prefix_size;
+    /** \brief First bytes of the name */
+    char prefix[NAMECACHE_PREFIX_SIZE];
+} namecache_entry_t;
+
+
+/** \brief Current cache generation, entries from older generations are invalid */
+static U32 namecache_generation = 1u;
+
+/** \brief Cached names (open addressing on the target address) */
+static namecache_entry_t namecache_entries[NAMECACHE_ENTRY_COUNT];
+
+/** \brief Cached names kept while the cache is rebuilt */
+static namecache_entry_t namecache_kept_entries[NAMECACHE_ENTRY_COUNT];
+
+
+
+/** \brief Compute the first cache slot for a target address */
+static U32 NAMECACHE_hash(const U32 address)
+{
+    /* Knuth multiplicative hash */
+    return ((address * 2654435761u) >> 16u) & (NAMECACHE_ENTRY_COUNT - 1u);
+}
+
+
+/** \brief Invalidate all the cached names (target reset or flash write) */
+void NAMECACHE_invalidate(void)
+{
+    /* Entries from the previous generations are not valid anymore */
+    namecache_generation++;
+    if (namecache_generation == 0u)
+    {
+        memset(namecache_entries, 0, sizeof(namecache_entries));
+        namecache_generation = 1u;
+    }
+}
+
+/** \brief Look for the cache entry of the name stored at a given target address (returns NULL if it is not cached) */
+static const namecache_entry_t* NAMECACHE_findEntry(const U32 address)
+{
+    U32 i;
+    const namecache_entry_t* found = NULL;
+    U32 slot = NAMECACHE_hash(address);
+
+    /* Probe the slots until the name or a free slot is found */
+    for (i = 0; (i < NAMECACHE_ENTRY_COUNT) && (found == NULL); i++)
+    {
+        const namecache_entry_t* const entry = &namecache_entries[slot];
+        if (entry->generation != namecache_generation)
+        {
+            break;
+        }
+        if (entry->address == address)
+        {
+            found = entry;
+        }
+        slot = (slot + 1u) & (NAMECACHE_ENTRY_COUNT - 1u);
+    }
+
+    return found;
+}
+
+
+/** \brief Look for the string pool handle of the name stored at a given target address (returns false if it is not cached) */
+bool NAMECACHE_find(const U32 address, U32* const name)
+{
+    const namecache_entry_t* const entry = NAMECACHE_findEntry(address);
+    if (entry != NULL)
+    {
+        (*name) = entry->name;
+    }
+    return (entry != NULL);
+}
+
+/** \brief Look for the string pool handle of the name stored at a given target address if its first bytes have not changed
+           (returns false if it is not cached or if it has been rebuilt) */
+bool NAMECACHE_check(const U32 address, const char* const prefix, const U32 prefix_size, U32* const name)
+{
+    bool ret = false;
+    const namecache_entry_t* const entry = NAMECACHE_findEntry(address);
+    if ((entry != NULL) && (entry->prefix_size == prefix_size) && (memcmp(entry->prefix, prefix, prefix_size) == 0))
+    {
+        (*name) = entry->name;
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Add the string pool handle and the first bytes of the name stored at a given target address */
+void NAMECACHE_add(const U32 address, const U32 name, const char* const prefix, const U32 prefix_size)
+{
+    U32 i;
+    U32 slot = NAMECACHE_hash(address);
+
+    /* Look for a free slot, the name is not cached if the cache is full */
+    for (i = 0; i < NAMECACHE_ENTRY_COUNT; i++)
+    {
+        namecache_entry_t* const entry = &namecache_entries[slot];
+        if ((entry->generation != namecache_generation) || (entry->address == address))
+        {
+            entry->address = address;
+            entry->generation = namecache_generation;
+            entry->name = name;
+            entry->prefix_size = ((prefix_size < NAMECACHE_PREFIX_SIZE) ? prefix_size : NAMECACHE_PREFIX_SIZE);
+            memcpy(entry->prefix, prefix, entry->prefix_size);
+            break;
+        }
+        slot = (slot + 1u) & (NAMECACHE_ENTRY_COUNT - 1u);
+    }
+}
+
+/** \brief Move the cached names to a rebuilt string pool (the names which are not in the rebuilt pool are forgotten) */
+void NAMECACHE_rebuild(const stringpool_t* const previous_pool, const stringpool_t* const pool)
+{
+    U32 i;
+    U32 kept_count = 0u;
+
+    /* Keep the names which are still in use with their new handle */
+    for (i = 0; i < NAMECACHE_ENTRY_COUNT; i++)
+    {
+        const namecache_entry_t* const entry = &namecache_entries[i];
+        U32 name;
+        if ((entry->generation == namecache_generation) && STRINGPOOL_find(pool, STRINGPOOL_get(previous_pool, entry->name), &name))
+        {
+            memcpy(&namecache_kept_entries[kept_count], entry, sizeof(namecache_entry_t));
+            namecache_kept_entries[kept_count].name = name;
+            kept_count++;
+        }
+    }
+
+    /* Add them again so that the slots of the forgotten names are free */
+    NAMECACHE_invalidate();
+    for (i = 0; i < kept_count; i++)
+    {
+        const namecache_entry_t* const entry = &namecache_kept_entries[i];
+        NAMECACHE_add(entry->address, entry->name, entry->prefix, entry->prefix_size);
+    }
+}
@@ -0,0 +1,54 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAMECACHE_H
+#define NAMECACHE_H
+
+#include "RTOSPlugin.h"
+#include "StringPool.h"
+
+#include <stdbool.h>
+
+
+/** \brief Number of entries in the name cache (must be a power of 2) */
+#define NAMECACHE_ENTRY_COUNT   1024u
+
+/** \brief Maximum number of first bytes of a name kept to check that it has not been rebuilt */
+#define NAMECACHE_PREFIX_SIZE   16u
+
+
+
+/** \brief Invalidate all the cached names (target reset or flash write) */
+void NAMECACHE_invalidate(void);
+
+/** \brief Look for the string pool handle of the name stored at a given target address (returns false if it is not cached) */
+bool NAMECACHE_find(const U32 address, U32* const name);
+
+/** \brief Look for the string pool handle of the name stored at a given target address if its first bytes have not changed
+           (returns false if it is not cached or if it has been rebuilt) */
+bool NAMECACHE_check(const U32 address, const char* const prefix, const U32 prefix_size, U32* const name);
+
+/** \brief Add the string pool handle and the first bytes of the name stored at a given target address */
+void NAMECACHE_add(const U32 address, const U32 name, const char* const prefix, const U32 prefix_size);
+
+/** \brief Move the cached names to a rebuilt string pool (the names which are not in the rebuilt pool are forgotten) */
+void NAMECACHE_rebuild(const stringpool_t* const previous_pool, const stringpool_t* const pool);
+
+
+#endif /* NAMECACHE_H */
@@ -0,0 +1,382 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Profiler.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+
+/** \brief Address bucket of the heatmap */
+typedef struct _profiler_bucket_t
+{
+    /** \brief Indicate if the bucket is used */
+    bool used;
+    /** \brief Start address in the target memory */
+    U32 address;
+    /** \brief Last halt during which the bucket has been read */
+    U32 halt;
+    /** \brief Mask of the bytes of the bucket with a known content */
+    U32 known_mask;
+    /** \brief Last content read */
+    U8 content[PROFILER_BUCKET_SIZE];
+    /** \brief Number of reads per calling site */
+    U32 reads[PROFILER_SITE_MAX];
+    /** \brief Number of bytes read */
+    U32 bytes;
+    /** \brief Number of reads of the bucket already read during the same halt */
+    U32 redundant_reads;
+    /** \brief Number of reads of the bucket returning the same content than at a previous halt */
+    U32 unchanged_reads;
+} profiler_bucket_t;
+
+
+/** \brief Names of the calling sites */
+static const char* const profiler_site_names[PROFILER_SITE_MAX] = {
+                                                                    "offsets",
+                                                                    "os_infos",
+                                                                    "tcb",
+                                                                    "name",
+                                                                    "wait_object",
+                                                                    "stack_frame",
+                                                                    "read_plan",
+                                                                    "other"
+                                                                  };
+
+/** \brief GDB server API used to access the target */
+static const GDB_API* profiler_target_api = NULL;
+
+/** \brief Profiling API */
+static GDB_API profiler_api;
+
+/** \brief Path to the profile file (NULL if the profiler is not started) */
+static const char* profiler_path = NULL;
+
+/** \brief Symbols used to label the addresses */
+static const RTOS_SYMBOLS* profiler_symbols = NULL;
+
+/** \brief Heatmap buckets */
+static profiler_bucket_t* profiler_buckets = NULL;
+
+/** \brief Number of reads which could not be recorded because the heatmap is full */
+static U32 profiler_dropped_reads = 0u;
+
+/** \brief Counters of the calling sites */
+static profiler_site_counters_t profiler_sites[PROFILER_SITE_MAX];
+
+/** \brief Current calling site */
+static profiler_site_t profiler_current_site = PROFILER_SITE_OTHER;
+
+/** \brief Current halt */
+static U32 profiler_halt = 1u;
+
+
+
+/** \brief Get the bucket of an address, creating it if needed (NULL if the heatmap is full) */
+static profiler_bucket_t* PROFILER_getBucket(const U32 address)
+{
+    profiler_bucket_t* bucket = NULL;
+    U32 tries = 0u;
+    U32 slot = ((address / PROFILER_BUCKET_SIZE) * 2654435761u) & (PROFILER_MAX_BUCKETS - 1u);
+
+    while ((bucket == NULL) && (tries < PROFILER_MAX_BUCKETS))
+    {
+        profiler_bucket_t* const candidate = &profiler_buckets[slot];
+        if (!candidate->used)
+        {
+            /* New bucket */
+            memset(candidate, 0, sizeof(profiler_bucket_t));
+            candidate->used = true;
+            candidate->address = address;
+            bucket = candidate;
+        }
+        else if (candidate->address == address)
+        {
+            bucket = candidate;
+        }
+        else
+        {
+            slot = (slot + 1u) & (PROFILER_MAX_BUCKETS - 1u);
+            tries++;
+        }
+    }
+
+    return bucket;
+}
+
+/** \brief Record a target read */
+static void PROFILER_record(const U32 address, const U8* const data, const U32 size)
+{
+    U32 offset = 0u;
+    profiler_site_counters_t* const site = &profiler_sites[profiler_current_site];
+
+    site->reads++;
+    site->bytes += size;
+
+    /* Go through all the buckets covered by the read */
+    while (offset < size)
+    {
+        const U32 bucket_address = (address + offset) & ~(PROFILER_BUCKET_SIZE - 1u);
+        const U32 bucket_offset = (address + offset) - bucket_address;
+        U32 length = PROFILER_BUCKET_SIZE - bucket_offset;
+        profiler_bucket_t* const bucket = PROFILER_getBucket(bucket_address);
+        if (length > (size - offset))
+        {
+            length = size - offset;
+        }
+        if (bucket != NULL)
+        {
+            const U32 mask = ((length == 32u) ? 0xFFFFFFFFu : ((1u << length) - 1u)) << bucket_offset;
+
+            bucket->reads[profiler_current_site]++;
+            bucket->bytes += length;
+            if (bucket->halt == profiler_halt)
+            {
+                /* Already read during this halt */
+                bucket->redundant_reads++;
+                site->redundant_bytes += length;
+            }
+            else if (((bucket->known_mask & mask) == mask) && (memcmp(&bucket->content[bucket_offset], &data[offset], length) == 0))
+            {
+                /* Same content than at a previous halt */
+                bucket->unchanged_reads++;
+                site->unchanged_bytes += length;
+            }
+            memcpy(&bucket->content[bucket_offset], &data[offset], length);
+            bucket->known_mask |= mask;
+            bucket->halt = profiler_halt;
+        }
+        else
+        {
+            profiler_dropped_reads++;
+        }
+        offset += length;
+    }
+}
+
+/** \brief Compare the address of 2 buckets, the unused buckets are sorted at the end */
+static int PROFILER_compareBuckets(const void* a, const void* b)
+{
+    const profiler_bucket_t* const bucket_a = (const profiler_bucket_t*)a;
+    const profiler_bucket_t* const bucket_b = (const profiler_bucket_t*)b;
+    int ret = 0;
+    if (bucket_a->used != bucket_b->used)
+    {
+        ret = (bucket_a->used ? -1 : 1);
+    }
+    else if (bucket_a->address < bucket_b->address)
+    {
+        ret = -1;
+    }
+    else if (bucket_a->address > bucket_b->address)
+    {
+        ret = 1;
+    }
+    return ret;
+}
+
+/** \brief Build the label of an address from the closest symbol before it */
+static void PROFILER_getLabel(const U32 address, char label[], const size_t label_size)
+{
+    const RTOS_SYMBOLS* symbol;
+    const RTOS_SYMBOLS* closest_symbol = NULL;
+
+    label[0u] = 0;
+    for (symbol = profiler_symbols; (symbol != NULL) && (symbol->name != NULL); symbol++)
+    {
+        if ((symbol->address != 0u) && (symbol->address <= address) && ((address - symbol->address) < PROFILER_MAX_SYMBOL_OFFSET))
+        {
+            if ((closest_symbol == NULL) || (symbol->address > closest_symbol->address))
+            {
+                closest_symbol = symbol;
+            }
+        }
+    }
+    if (closest_symbol != NULL)
+    {
+        snprintf(label, label_size, "%s+0x%x", closest_symbol->name, address - closest_symbol->address);
+    }
+}
+
+/** \brief Export the heatmap to the profile file at the end of the process */
+static void PROFILER_export(void)
+{
+    FILE* const file = fopen(profiler_path, "w");
+    if (file != NULL)
+    {
+        U32 i;
+        U32 site;
+
+        /* Summary per calling site */
+        fprintf(file, "# halts=%u dropped_reads=%u\n", profiler_halt - 1u, profiler_dropped_reads);
+        fprintf(file, "# site,reads,bytes,redundant_bytes,unchanged_bytes\n");
+        for (site = 0u; site < PROFILER_SITE_MAX; site++)
+        {
+            const profiler_site_counters_t* const counters = &profiler_sites[site];
+            fprintf(file, "# %s,%u,%u,%u,%u\n", profiler_site_names[site], counters->reads, counters->bytes,
+                                                counters->redundant_bytes, counters->unchanged_bytes);
+        }
+
+        /* Heatmap sorted by address */
+        qsort(profiler_buckets, PROFILER_MAX_BUCKETS, sizeof(profiler_bucket_t), PROFILER_compareBuckets);
+        fprintf(file, "address,label,bytes,redundant_reads,unchanged_reads");
+        for (site = 0u; site < PROFILER_SITE_MAX; site++)
+        {
+            fprintf(file, ",%s", profiler_site_names[site]);
+        }
+        fprintf(file, "\n");
+        for (i = 0u; (i < PROFILER_MAX_BUCKETS) && profiler_buckets[i].used; i++)
+        {
+            char label[64u];
+            const profiler_bucket_t* const bucket = &profiler_buckets[i];
+            PROFILER_getLabel(bucket->address, label, sizeof(label));
+            fprintf(file, "0x%08x,%s,%u,%u,%u", bucket->address, label, bucket->bytes, bucket->redundant_reads, bucket->unchanged_reads);
+            for (site = 0u; site < PROFILER_SITE_MAX; site++)
+            {
+                fprintf(file, ",%u", bucket->reads[site]);
+            }
+            fprintf(file, "\n");
+        }
+        fclose(file);
+    }
+}
+
+/** \brief Read a memory area */
+static int PROFILER_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    const int ret = profiler_target_api->pfReadMem(Addr, pData, NumBytes);
+    if (ret != 0)
+    {
+        PROFILER_record(Addr, (const U8*)pData, NumBytes);
+    }
+    return ret;
+}
+
+/** \brief Read a byte */
+static char PROFILER_ReadU8(U32 Addr, U8* pData)
+{
+    const char ret = profiler_target_api->pfReadU8(Addr, pData);
+    if (ret == 0)
+    {
+        PROFILER_record(Addr, pData, 1u);
+    }
+    return ret;
+}
+
+/** \brief Read a half word */
+static char PROFILER_ReadU16(U32 Addr, U16* pData)
+{
+    const char ret = profiler_target_api->pfReadU16(Addr, pData);
+    if (ret == 0)
+    {
+        PROFILER_record(Addr, (const U8*)pData, 2u);
+    }
+    return ret;
+}
+
+/** \brief Read a word */
+static char PROFILER_ReadU32(U32 Addr, U32* pData)
+{
+    const char ret = profiler_target_api->pfReadU32(Addr, pData);
+    if (ret == 0)
+    {
+        PROFILER_record(Addr, (const U8*)pData, 4u);
+    }
+    return ret;
+}
+
+
+/** \brief Start the profiler if configured and get the profiling API
+           (the given API is returned as is if no profile file is configured) */
+const GDB_API* PROFILER_init(const GDB_API* const target_api, const RTOS_SYMBOLS* const symbols)
+{
+    const GDB_API* ret = target_api;
+    const char* const path = getenv(PROFILER_FILE_ENV_VAR);
+
+    /* The heatmap is kept across the sessions and exported at the end of the process */
+    if ((PROFILER_ENABLED == 1) && (profiler_path == NULL) && (path != NULL) && (path[0u] != 0))
+    {
+        profiler_buckets = (profiler_bucket_t*)target_api->pfAlloc(PROFILER_MAX_BUCKETS * sizeof(profiler_bucket_t));
+        if (profiler_buckets != NULL)
+        {
+            memset(profiler_buckets, 0, PROFILER_MAX_BUCKETS * sizeof(profiler_bucket_t));
+            memset(profiler_sites, 0, sizeof(profiler_sites));
+            profiler_dropped_reads = 0u;
+            profiler_halt = 1u;
+            profiler_path = path;
+            (void)atexit(PROFILER_export);
+            target_api->pfLogOutf("Nano-OS plugin: profiling target reads to %s\n", path);
+        }
+        else
+        {
+            target_api->pfWarnOutf("Nano-OS plugin: unable to allocate the profiler heatmap\n");
+        }
+    }
+    if (profiler_path != NULL)
+    {
+        /* Build the profiling API */
+        profiler_target_api = target_api;
+        profiler_symbols = symbols;
+        profiler_api = (*target_api);
+        profiler_api.pfReadMem = PROFILER_ReadMem;
+        profiler_api.pfReadU8 = PROFILER_ReadU8;
+        profiler_api.pfReadU16 = PROFILER_ReadU16;
+        profiler_api.pfReadU32 = PROFILER_ReadU32;
+        ret = &profiler_api;
+    }
+
+    return ret;
+}
+
+/** \brief Set the calling site of the next target reads */
+void PROFILER_setSite(const profiler_site_t site)
+{
+    profiler_current_site = site;
+}
+
+/** \brief Signal the start of a new halt */
+void PROFILER_newHalt(void)
+{
+    profiler_halt++;
+}
+
+/** \brief Get the name of a calling site */
+const char* PROFILER_getSiteName(const profiler_site_t site)
+{
+    const char* ret = "";
+    if (site < PROFILER_SITE_MAX)
+    {
+        ret = profiler_site_names[site];
+    }
+    return ret;
+}
+
+/** \brief Get the counters of all the calling sites since the start of the profiler (all zero if it is not started) */
+void PROFILER_getSiteCounters(profiler_site_counters_t counters[PROFILER_SITE_MAX])
+{
+    if (profiler_path != NULL)
+    {
+        memcpy(counters, profiler_sites, sizeof(profiler_sites));
+    }
+    else
+    {
+        memset(counters, 0, sizeof(profiler_sites));
+    }
+}
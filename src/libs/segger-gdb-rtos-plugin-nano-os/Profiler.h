@@ -0,0 +1,113 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Enable the build of the target read profiler */
+#define PROFILER_ENABLED            1
+
+/** \brief Name of the environment variable containing the path to the profile file (CSV format) */
+#define PROFILER_FILE_ENV_VAR       "NANO_OS_PLUGIN_PROFILE_FILE"
+
+/** \brief Size in bytes of an address bucket of the heatmap (power of 2, 32 max) */
+#define PROFILER_BUCKET_SIZE        32u
+
+/** \brief Maximum number of address buckets of the heatmap (power of 2) */
+#define PROFILER_MAX_BUCKETS        16384u
+
+/** \brief Maximum distance in bytes between an address and the symbol used to label it */
+#define PROFILER_MAX_SYMBOL_OFFSET  0x10000u
+
+
+/** \brief Calling sites of the target reads */
+typedef enum _profiler_site_t
+{
+    /** \brief Data structure offsets */
+    PROFILER_SITE_OFFSETS = 0u,
+    /** \brief OS state (current task, tick count) */
+    PROFILER_SITE_OS_INFOS,
+    /** \brief Task control block fields, including the port data holding the VFP flag which is read along with them */
+    PROFILER_SITE_TCB,
+    /** \brief Task and wait object names */
+    PROFILER_SITE_NAME,
+    /** \brief Wait object fields */
+    PROFILER_SITE_WAIT_OBJECT,
+    /** \brief Saved thread contexts */
+    PROFILER_SITE_STACK_FRAME,
+    /** \brief Merged wait object and saved context reads */
+    PROFILER_SITE_READ_PLAN,
+    /** \brief Other reads */
+    PROFILER_SITE_OTHER,
+
+    /** \brief Number of sites */
+    PROFILER_SITE_MAX
+} profiler_site_t;
+
+/** \brief Counters of a calling site */
+typedef struct _profiler_site_counters_t
+{
+    /** \brief Number of reads */
+    U32 reads;
+    /** \brief Number of bytes read */
+    U32 bytes;
+    /** \brief Number of bytes already read during the same halt */
+    U32 redundant_bytes;
+    /** \brief Number of bytes returning the same content than at a previous halt */
+    U32 unchanged_bytes;
+} profiler_site_counters_t;
+
+
+#if (PROFILER_ENABLED == 1)
+
+/** \brief Macro to set the calling site of the next target reads */
+#define PROFILER_SITE(site)         PROFILER_setSite(site)
+
+/** \brief Macro to signal the start of a new halt */
+#define PROFILER_HALT()             PROFILER_newHalt()
+
+#else
+
+#define PROFILER_SITE(site)
+#define PROFILER_HALT()
+
+#endif /* (PROFILER_ENABLED == 1) */
+
+
+/** \brief Start the profiler if configured and get the profiling API
+           (the given API is returned as is if no profile file is configured) */
+const GDB_API* PROFILER_init(const GDB_API* const target_api, const RTOS_SYMBOLS* const symbols);
+
+/** \brief Set the calling site of the next target reads */
+void PROFILER_setSite(const profiler_site_t site);
+
+/** \brief Signal the start of a new halt */
+void PROFILER_newHalt(void);
+
+/** \brief Get the name of a calling site */
+const char* PROFILER_getSiteName(const profiler_site_t site);
+
+/** \brief Get the counters of all the calling sites since the start of the profiler (all zero if it is not started) */
+void PROFILER_getSiteCounters(profiler_site_counters_t counters[PROFILER_SITE_MAX]);
+
+
+#endif /* PROFILER_H */
@@ -40,8 +40,19 @@ along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
 #include "JLINKARM_Const.h"
 
 #include "CortexM.h"
+#include "MemCache.h"
+#include "ElfMem.h"
+#include "NameCache.h"
+#include "ReadPlan.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Profiler.h"
+#include "Recorder.h"
+#include "Region.h"
+#include "StringPool.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 
 /*********************************************************************
@@ -65,6 +76,12 @@ along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
 /** \brief Invalid 16 bits data structure offset */
 #define NANO_OS_PLUGIN_INVALID_OFFSET16 0xFFFFu
 
+/** \brief Maximum size in bytes of the task control block span read in one transfer (8 bits offset + 32 bits field) */
+#define NANO_OS_PLUGIN_MAX_TCB_SPAN_SIZE    (NANO_OS_PLUGIN_INVALID_OFFSET8 + 4u)
+
+/** \brief Maximum size in bytes of the wait object span read in one transfer (8 bits offset + 32 bits field) */
+#define NANO_OS_PLUGIN_MAX_WAIT_OBJECT_SPAN_SIZE    (NANO_OS_PLUGIN_INVALID_OFFSET8 + 4u)
+
 
 
 /*********************************************************************
@@ -77,13 +94,39 @@ along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
 /** \brief The plugin version number as unsigned integer: 100 * [major] + [minor] */
 #define NANO_OS_PLUGIN_VERSION                  100u
 
-/** \brief Maximum number of threads */
-#define NANO_OS_PLUGIN_MAX_THREAD_COUNT         1024u
+/** \brief Maximum number of threads (size of the 16 bits thread id space) */
+#define NANO_OS_PLUGIN_MAX_THREAD_COUNT         65536u
+
+/** \brief Initial number of entries of the thread list, doubled each time more threads are found (power of 2) */
+#define NANO_OS_PLUGIN_MIN_THREAD_CAPACITY      16u
+
+/** \brief Initial number of entries of the thread id index, doubled until it covers the highest thread id (power of 2) */
+#define NANO_OS_PLUGIN_MIN_THREAD_ID_INDEX_SIZE 64u
+
+/** \brief Maximum length of the strings read in the target memory (without null terminator) */
+#define NANO_OS_PLUGIN_MAX_STRING_LENGTH        254u
+
+/** \brief Maximum gap in bytes between 2 planned target reads to merge them into a single transfer */
+#define NANO_OS_PLUGIN_READ_PLAN_MAX_GAP        64u
+
+/** \brief Enable the load of the saved contexts of all the non running threads during the update
+           (otherwise they are loaded on the first register access) */
+#define NANO_OS_PLUGIN_STACK_PREFETCH_ENABLED   1
+
+/** \brief Name of the environment variable disabling the stack prefetch at run time when its value is 0 */
+#define NANO_OS_PLUGIN_STACK_PREFETCH_ENV_VAR   "NANO_OS_PLUGIN_STACK_PREFETCH"
+
+/** \brief Enable the lazy load of the thread details: the update only walks the thread list and the details
+           of a thread are loaded on its first access during the halt (disables the stack prefetch) */
+#define NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED  0
 
 
 /** \brief Enable debug prints */
 #define NANO_OS_PLUGIN_DEBUG_PRINT_ENABLED      1
 
+/** \brief Enable warning prints */
+#define NANO_OS_PLUGIN_WARNING_PRINT_ENABLED    1
+
 /** \brief Enable error prints */
 #define NANO_OS_PLUGIN_ERROR_PRINT_ENABLED      1
 
@@ -95,6 +138,13 @@ along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
 #define LOG_DEBUG(string, ...)
 #endif /* (NANO_OS_PLUGIN_DEBUG_PRINT_ENABLED == 1) */
 
+#if (NANO_OS_PLUGIN_WARNING_PRINT_ENABLED == 1)
+/** \brief Macro to print a warning string */
+#define LOG_WARNING(string, ...)                gdb_api->pfWarnOutf((string), ##__VA_ARGS__)
+#else
+#define LOG_WARNING(string, ...)
+#endif /* (NANO_OS_PLUGIN_WARNING_PRINT_ENABLED == 1) */
+
 #if (NANO_OS_PLUGIN_ERROR_PRINT_ENABLED == 1)
 /** \brief Macro to print an error string */
 #define LOG_ERROR(string, ...)                  gdb_api->pfErrorOutf((string), ##__VA_ARGS__)
@@ -102,6 +152,12 @@ along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
 #define LOG_ERROR(string, ...)
 #endif /* (NANO_OS_PLUGIN_ERROR_PRINT_ENABLED == 1) */
 
+/** \brief Macro to mark the start of an exported entry point called with the given arguments */
+#define ENTRY_POINT_ENTER(entry, arg0, arg1)    RECORDER_CALL(RECORDER_CALL_##entry, arg0, arg1); STATS_ENTER(STATS_ENTRY_##entry); TRACE_BEGIN(__func__)
+
+/** \brief Macro to mark the end of an exported entry point */
+#define ENTRY_POINT_LEAVE(entry)                TRACE_END(__func__); STATS_LEAVE(STATS_ENTRY_##entry)
+
 /*********************************************************************
 *
 *       Types, local
@@ -162,43 +218,83 @@ typedef struct _nano_os_wait_object_t
 {
     /** \brief Id */
     U16 id;
-    /** \brief Name */
-    char name[255u];
+    /** \brief Handle of the name in the name pool */
+    U32 name;
     /** \brief Type */
     U8 type;
+    /** \brief Address in the target memory */
+    U32 address;
+    /** \brief Number of threads waiting on the object */
+    U32 waiter_count;
+    /** \brief Indicate if the raw content of the wait object span has been read */
+    bool loaded;
+    /** \brief Raw content of the wait object span */
+    U8 data[NANO_OS_PLUGIN_MAX_WAIT_OBJECT_SPAN_SIZE];
 } nano_os_wait_object_t;
 
-/** \brief Nano OS thread data */
+/** \brief Nano OS thread data, only the fields used to walk, look up and display the threads
+           (the buffers are stored separately at the same index in a nano_os_thread_data_t array) */
 typedef struct _nano_os_thread_t
 {
-    /** \brief Id */
-    U16 id;
-    /** \brief Name */
-    char name[255u];
-    /** \brief State */
-    U8 state;
-    /** \brief Priority */
-    U8 priority;
+    /** \brief Address of the task control block in the target memory (0 if the entry is not a valid snapshot) */
+    U32 address;
+    /** \brief Address of the task control block in the target memory found during the last thread list walk */
+    U32 tcb_address;
+    /** \brief Next thread address */
+    U32 next_thread;
     /** \brief Top of stack address */
     U32 top_of_stack_address;
     /** \brief Top of stack address without stack frame */
     U32 top_of_stack_without_stack_frame_address;
-    /** \brief Top of stack */
-    U8* top_of_stack;
+    /** \brief Local copy of the saved context, in the transient memory of the update it has been loaded in */
+    U8* stack;
+    /** \brief Offset of the top of stack in the local copy of the saved context */
+    U32 top_of_stack_offset;
     /** \brief Stack size */
     U32 stack_size;
-    /** \brief Indicate if the stack has already been loaded */
-    bool stack_loaded;
-    /* Top of thread stack (contains thread context) */
-    U8 stack[1024u];
-    /** \brief Wait object */
-    nano_os_wait_object_t wait_object;
+    /** \brief Size in bytes of the saved context */
+    U32 stack_frame_size;
+    /** \brief Wait object address in the target memory */
+    U32 wait_object_address;
     /** \brief Wait timeout */
     U32 wait_timeout;
-    /** \brief Next thread address */
-    U32 next_thread;
+    /** \brief Handle of the name in the name pool */
+    U32 name;
+    /** \brief Wait object (NULL if the thread is not waiting on an object) */
+    nano_os_wait_object_t* wait_object;
+    /** \brief CPU registers saved in the context, selected from the port specific data of the thread */
+    const nano_os_cpu_register_set_t* cpu_reg_set;
+    /** \brief Id */
+    U16 id;
+    /** \brief State */
+    U8 state;
+    /** \brief Priority */
+    U8 priority;
+    /** \brief Indicate if the saved context has already been loaded */
+    bool stack_loaded;
+    /** \brief Indicate if the thread details have been loaded during the current halt */
+    bool details_loaded;
+    /** \brief Indicate if the task control block span has been prefetched for the current update */
+    bool tcb_prefetched;
 } nano_os_thread_t;
 
+/** \brief Nano OS thread buffers, only accessed when a thread is decoded or when its registers are read */
+typedef struct _nano_os_thread_data_t
+{
+    /** \brief Raw content of the task control block span at the last update */
+    U8 tcb[NANO_OS_PLUGIN_MAX_TCB_SPAN_SIZE];
+    /** \brief Raw content of the task control block span prefetched for the current update */
+    U8 prefetched_tcb[NANO_OS_PLUGIN_MAX_TCB_SPAN_SIZE];
+} nano_os_thread_data_t;
+
+/** \brief Entry of the lookup table of the previous thread snapshots */
+typedef struct _nano_os_snapshot_slot_t
+{
+    /** \brief Address of the task control block in the target memory (0 if free) */
+    U32 address;
+    /** \brief Index of the snapshot in the thread list */
+    U32 index;
+} nano_os_snapshot_slot_t;
 
 
 /** \brief Nano OS plugin internal data */
@@ -209,22 +305,52 @@ typedef struct _nano_os_plugin_t
 
     /** \brief Selected CPU */
     const nano_os_cpu_port_t* cpu;
-    /** \brief Selected CPU stack frame size in bytes */
-    U32 cpu_stack_frame_size;
     
     /** \brief Indicate if the OS is tarted */
     bool os_started;
 
+    /** \brief Indicate if the saved contexts of the non running threads are loaded during the update */
+    bool stack_prefetch;
+
     /** \brief Indicate if the data structure offsets have been loaded */
     bool offsets_loaded;
 
     /** \brief Nano OS data structure offsets */
     nano_os_data_structure_offsets_t offsets;
+    /** \brief Start offset of the task control block span read in one transfer */
+    U8 task_span_start;
+    /** \brief Size in bytes of the task control block span read in one transfer */
+    U16 task_span_size;
+    /** \brief Start offset of the task control block span containing the thread list links */
+    U8 task_link_span_start;
+    /** \brief Size in bytes of the task control block span containing the thread list links */
+    U16 task_link_span_size;
+    /** \brief Start offset of the wait object span read in one transfer */
+    U8 wait_object_span_start;
+    /** \brief Size in bytes of the wait object span read in one transfer */
+    U16 wait_object_span_size;
 
     /** \brief Thread count */
     U32 thread_count;
-    /** \brief Thread list */
-    nano_os_thread_t threads[NANO_OS_PLUGIN_MAX_THREAD_COUNT];
+    /** \brief Number of entries allocated in the thread list */
+    U32 thread_capacity;
+    /** \brief Thread list, grown on demand */
+    nano_os_thread_t* threads;
+    /** \brief Buffers of the threads, at the same index as in the thread list */
+    nano_os_thread_data_t* thread_data;
+    /** \brief Transient memory of the current update */
+    region_t region;
+    /** \brief Lookup table of the previous thread snapshots by task control block address,
+               in the transient memory of the update (twice as many entries as the snapshots) */
+    nano_os_snapshot_slot_t* snapshot_table;
+    /** \brief Number of entries of the snapshot lookup table (power of 2, 0 if the snapshots are not reused) */
+    U32 snapshot_table_size;
+    /** \brief Index following the last entry of the thread list which may hold a previous snapshot */
+    U32 snapshot_end;
+    /** \brief Index of the threads by id (index + 1, 0 if free) */
+    U32* thread_id_index;
+    /** \brief Number of entries of the thread id index */
+    U32 thread_id_index_size;
     /** \brief Tick count */
     U32 tick_count;
 
@@ -233,10 +359,24 @@ typedef struct _nano_os_plugin_t
     /** \brief Current thread index */
     U32 current_thread_index;
 
+    /** \brief Wait objects referenced by the threads during the last update, in the transient memory of the update */
+    nano_os_wait_object_t* wait_objects;
+    /** \brief Number of entries allocated for the wait objects */
+    U32 wait_object_capacity;
+    /** \brief Wait object count */
+    U32 wait_object_count;
+    /** \brief Lookup table of the wait objects by address (index + 1, 0 if free, twice as many entries as the wait objects) */
+    U32* wait_object_table;
+
     /** \brief Thread list address in the target memory */
     U32 target_thread_list_address;
     /** \brief Current thread address in the target memory */
     U32 target_current_thread_address;
+
+    /** \brief Names of the threads and of the wait objects, each distinct name is stored once */
+    stringpool_t names;
+    /** \brief Number of bytes used by the names after the last rebuild of their pool */
+    U32 names_rebuilt_size;
 } nano_os_plugin_t;
 
 /** \brief Nano OS task states */
@@ -321,6 +461,9 @@ static const char* nano_os_thread_states[] = {
                                                 "DEAD"
                                              };
 
+/** \brief Wait object displayed for pending threads which are not waiting on an object */
+static const nano_os_wait_object_t nano_os_no_wait_object;
+
 /** \brief Nano OS wait object type strings */
 static const char* nano_os_wait_object_types[] = {
                                                     "NOT_INIT",
@@ -342,23 +485,93 @@ static const char* nano_os_wait_object_types[] = {
 */
 
 
-/** \brief Read a string in target memory */
-static bool readString(const U32 string_address, char string[], const U32 string_size);
+/** \brief Read a string in target memory, or get it from the name cache (a cached name is checked against its first bytes if requested) */
+static bool readString(const U32 string_content_address, const bool check, U32* const name);
+
+/** \brief Forget all the names read from the target */
+static void invalidateNames(void);
+
+/** \brief Rebuild the name pool with only the names still used by the threads and the wait objects */
+static void rebuildNames(void);
 
 /** \brief Look for a thread with the given id */
 static nano_os_thread_t* findThread(const U32 id);
 
+/** \brief Get the buffers of a thread */
+static nano_os_thread_data_t* getThreadData(const nano_os_thread_t* const thread);
+
+/** \brief Release the thread list, the wait objects, their lookup tables and the names */
+static void releaseThreads(void);
+
+/** \brief Make room for the given number of threads in the thread list and the wait objects */
+static bool reserveThreads(const U32 thread_count);
+
+/** \brief Allocate the wait objects of the current update, the wait objects already registered are moved */
+static bool allocateWaitObjects(const U32 capacity);
+
+/** \brief Update the thread id index with the threads found during the last update */
+static void indexThreads(void);
+
 /** \brief Fill Nano OS offsets */
 static bool fillNanoOsOffsets(void);
 
+/** \brief Compute the task control block span covering all the decoded fields */
+static void computeTaskSpan(void);
+
 /** \brief Fill informations about Nano OS */
 static bool fillNanoOsInfos(void);
 
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0)
+/** \brief Prefetch the task control blocks of the threads known from the previous update */
+static void prefetchThreads(const U32 previous_thread_count);
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0) */
+
+/** \brief Build the lookup table of the thread snapshots of the previous update */
+static void indexSnapshots(const U32 previous_thread_count);
+
+/** \brief Get the slot of a thread snapshot in the lookup table, or the free slot where to register it */
+static U32 findSnapshotSlot(const U32 thread_address);
+
+/** \brief Get the thread entry to refresh, reusing the previous snapshot of the thread if any */
+static nano_os_thread_t* getThreadEntry(const U32 thread_address, const U32 index);
+
+/** \brief Cut a looping thread list before its first thread walked twice, given the index of a thread inside the loop
+           which is found again after the last thread of the list */
+static void truncateThreadLoop(const U32 loop_index);
+
 /** \brief Fill a thread information */
 static bool fillNanoOsThreadInfos(const U32 thread_address, nano_os_thread_t* const thread);
 
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 1)
+/** \brief Fill the thread information needed to walk the thread list */
+static bool fillNanoOsThreadLinks(const U32 thread_address, nano_os_thread_t* const thread);
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 1) */
+
+/** \brief Load the details of a thread if they have not been loaded yet during the halt */
+static bool loadThreadDetails(nano_os_thread_t* const thread);
+
+/** \brief Compute the wait object span covering all the decoded fields */
+static void computeWaitObjectSpan(void);
+
+/** \brief Get the slot of a wait object in the lookup table, or the free slot where to register it */
+static U32 findWaitObjectSlot(const U32 wait_object_address);
+
+/** \brief Get a wait object, registering it only once per update */
+static nano_os_wait_object_t* getWaitObject(const U32 wait_object_address);
+
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0)
+/** \brief Read the wait objects and saved contexts referenced during the thread list walk */
+static bool fillNanoOsDeferredInfos(void);
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0) */
+
 /** \brief Fill a wait object information */
-static bool fillNanoOsWaitObjectInfos(const U32 wait_object_address, nano_os_wait_object_t* const wait_object);
+static bool fillNanoOsWaitObjectInfos(nano_os_wait_object_t* const wait_object);
+
+/** \brief Get the address of the saved context of a thread and set its top of stack in the local copy */
+static U32 prepareThreadStack(nano_os_thread_t* const thread);
+
+/** \brief Allocate the local copy of the saved context of a thread in the transient memory of the current update */
+static bool allocateThreadStack(nano_os_thread_t* const thread);
 
 /** \brief Dump the stack of a thread */
 static bool dumpThreadStack(nano_os_thread_t* const thread);
@@ -376,9 +589,27 @@ EXPORT int RTOS_Init(const GDB_API *pAPI, U32 core)
     int ret = 0;
     const nano_os_cpu_port_t* cpu_list = NULL;
     const nano_os_cpu_port_t* const * cpu_family = nano_os_supported_cpus;
+    const char* const stack_prefetch = getenv(NANO_OS_PLUGIN_STACK_PREFETCH_ENV_VAR);
+
+    /* Release the threads of the previous session with the API they have been allocated with */
+    if (gdb_api != NULL)
+    {
+        releaseThreads();
+    }
+
+    /* Build the target memory access chain: the probe accesses are recorded if a session file is configured,
+       counted and traced if the statistics and the trace are enabled, the reads are done through the cache
+       unless they can be served from the firmware ELF file, and the plugin reads are profiled if the profiler
+       is enabled */
+    gdb_api = RECORDER_init(pAPI, nano_os_symbols);
+    gdb_api = STATS_init(gdb_api);
+    gdb_api = TRACE_init(gdb_api);
+    gdb_api = MEMCACHE_init(gdb_api);
+    gdb_api = ELFMEM_init(gdb_api);
+    gdb_api = PROFILER_init(gdb_api, nano_os_symbols);
+    RECORDER_CALL(RECORDER_CALL_INIT, core, 0u);
 
     /* Check selected core */
-    gdb_api = pAPI;
     while ((cpu_family != NULL) && (ret == 0))
     {
         cpu_list = (*cpu_family);
@@ -405,6 +636,8 @@ EXPORT int RTOS_Init(const GDB_API *pAPI, U32 core)
         LOG_DEBUG("Initialized for %s\n", cpu_list->cpu_name);
         memset(&nano_os_plugin, 0, sizeof(nano_os_plugin));
         nano_os_plugin.cpu = cpu_list;
+        nano_os_plugin.stack_prefetch = ((NANO_OS_PLUGIN_STACK_PREFETCH_ENABLED == 1) && ((stack_prefetch == NULL) || (strcmp(stack_prefetch, "0") != 0)));
+        NAMECACHE_invalidate();
     }
     else
     {
@@ -432,6 +665,8 @@ EXPORT U32 RTOS_GetNumThreads()
 {
     U32 ret = 1;
 
+    ENTRY_POINT_ENTER(GET_NUM_THREADS, 0u, 0u);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
@@ -441,6 +676,7 @@ EXPORT U32 RTOS_GetNumThreads()
         }
     }
 
+    ENTRY_POINT_LEAVE(GET_NUM_THREADS);
     return ret;
 }
 
@@ -449,6 +685,8 @@ EXPORT U32 RTOS_GetCurrentThreadId()
 {
     int ret = 0;
 
+    ENTRY_POINT_ENTER(GET_CURRENT_THREAD_ID, 0u, 0u);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
@@ -458,6 +696,7 @@ EXPORT U32 RTOS_GetCurrentThreadId()
         }
     }
 
+    ENTRY_POINT_LEAVE(GET_CURRENT_THREAD_ID);
     return ret;
 }
 
@@ -466,12 +705,15 @@ EXPORT U32 RTOS_GetThreadId(U32 n)
 {
     int ret = 0;
 
+    ENTRY_POINT_ENTER(GET_THREAD_ID, n, 0u);
+
     /* Check index */
     if (n < nano_os_plugin.thread_count)
     {
         ret = nano_os_plugin.threads[n].id;
     }
 
+    ENTRY_POINT_LEAVE(GET_THREAD_ID);
     return ret;
 }
 
@@ -481,22 +723,32 @@ EXPORT int RTOS_GetThreadDisplay(char *pDisplay, U32 threadid)
 {
     int ret = 0;
 
+    ENTRY_POINT_ENTER(GET_THREAD_DISPLAY, threadid, 0u);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
         /* Look for the thread */
         nano_os_thread_t* thread = findThread(threadid);
-        if (thread != NULL)
+        if ((thread != NULL) && loadThreadDetails(thread))
         {
+            const char* const thread_name = STRINGPOOL_get(&nano_os_plugin.names, thread->name);
+
             /* Create the thread name */
             if (thread->state == NOS_TS_PENDING)
             {
                 char timeout_str[30u];
+                char waiters_str[30u] = "";
                 const U32 timeout = thread->wait_timeout - nano_os_plugin.tick_count;
+                const nano_os_wait_object_t* const wait_object = (thread->wait_object != NULL) ? thread->wait_object : &nano_os_no_wait_object;
                 const char* wait_object_type_name = "UNKNOWN";
-                if (thread->wait_object.type < WOT_MAX)
+                if (wait_object->type < WOT_MAX)
+                {
+                    wait_object_type_name = nano_os_wait_object_types[wait_object->type];
+                }
+                if ((wait_object->waiter_count > 1u) && (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0))
                 {
-                    wait_object_type_name = nano_os_wait_object_types[thread->wait_object.type];
+                    snprintf(waiters_str, sizeof(waiters_str), " (%u waiters)", wait_object->waiter_count);
                 }
                 if (timeout > 0xF0000000u)
                 {
@@ -506,23 +758,25 @@ EXPORT int RTOS_GetThreadDisplay(char *pDisplay, U32 threadid)
                 {
                     snprintf(timeout_str, sizeof(timeout_str), "%u ticks", timeout);
                 }
-                if (thread->wait_object.name[0u] != 0u)
+                if (wait_object->name != STRINGPOOL_EMPTY)
                 {
-                    ret = snprintf(pDisplay, 256u, "%s - %s [%s : %s - %s] - P%03d",
-                                   thread->name,
+                    ret = snprintf(pDisplay, 256u, "%s - %s [%s : %s%s - %s] - P%03d",
+                                   thread_name,
                                    nano_os_thread_states[thread->state],
                                    wait_object_type_name,
-                                   thread->wait_object.name,
+                                   STRINGPOOL_get(&nano_os_plugin.names, wait_object->name),
+                                   waiters_str,
                                    timeout_str,
                                    thread->priority);
                 }
                 else
                 {
-                    ret = snprintf(pDisplay, 256u, "%s - %s [%s : %d - %s] - P%03d",
-                                   thread->name,
+                    ret = snprintf(pDisplay, 256u, "%s - %s [%s : %d%s - %s] - P%03d",
+                                   thread_name,
                                    nano_os_thread_states[thread->state],
                                    wait_object_type_name,
-                                   thread->wait_object.id,
+                                   wait_object->id,
+                                   waiters_str,
                                    timeout_str,
                                    thread->priority);
                 }
@@ -530,14 +784,14 @@ EXPORT int RTOS_GetThreadDisplay(char *pDisplay, U32 threadid)
             else if (thread->state < NOS_TS_MAX)
             {
                 ret = snprintf(pDisplay, 256u, "%s - %s - P%03d", 
-                                                thread->name, 
+                                                thread_name, 
                                                 nano_os_thread_states[thread->state], 
                                                 thread->priority);
             }
             else
             {
                 ret = snprintf(pDisplay, 256u, "%s - UNKNOWN - P%03d",
-                               thread->name,
+                               thread_name,
                                thread->priority);
             }
         }
@@ -551,6 +805,7 @@ EXPORT int RTOS_GetThreadDisplay(char *pDisplay, U32 threadid)
         ret = snprintf(pDisplay, 256u, "CPU startup - Nano OS not started");
     }
 
+    ENTRY_POINT_LEAVE(GET_THREAD_DISPLAY);
     return ret;
 }
 
@@ -561,20 +816,21 @@ EXPORT int RTOS_GetThreadReg(char *pHexRegVal, U32 RegIndex, U32 threadid)
 {
     int ret = -1;
 
+    ENTRY_POINT_ENTER(GET_THREAD_REG, RegIndex, threadid);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
         /* Look for the thread */
         nano_os_thread_t* const thread = findThread(threadid);
-        if ((thread != NULL) && (thread != nano_os_plugin.current_thread))
+        if ((thread != NULL) && (thread != nano_os_plugin.current_thread) && loadThreadDetails(thread))
         {
             /* Dump thread stack */
             bool success = dumpThreadStack(thread);
             if (success)
             {
-                /* Get the register list */
-                const nano_os_cpu_register_set_t* const cpu_reg_set = nano_os_plugin.cpu->registers_get(gdb_api, nano_os_plugin.port_name,
-                                                                                                        nano_os_plugin.target_current_thread_address + nano_os_plugin.offsets.task_port_data_offset);
+                /* Get the register list of the thread */
+                const nano_os_cpu_register_set_t* const cpu_reg_set = thread->cpu_reg_set;
                 if (cpu_reg_set != NULL)
                 {
                     /* Look for the selected register */
@@ -582,7 +838,7 @@ EXPORT int RTOS_GetThreadReg(char *pHexRegVal, U32 RegIndex, U32 threadid)
                     if (cpu_reg != NULL)
                     {
                         CPU_getRegValue(nano_os_plugin.cpu, cpu_reg, 
-                                        thread->top_of_stack_without_stack_frame_address, thread->top_of_stack, pHexRegVal);
+                                        thread->top_of_stack_without_stack_frame_address, thread->stack + thread->top_of_stack_offset, pHexRegVal);
                         ret = 0;
                     }
                 }
@@ -590,6 +846,7 @@ EXPORT int RTOS_GetThreadReg(char *pHexRegVal, U32 RegIndex, U32 threadid)
         }
     }
 
+    ENTRY_POINT_LEAVE(GET_THREAD_REG);
     return ret;
 }
 
@@ -600,20 +857,21 @@ EXPORT int RTOS_GetThreadRegList(char *pHexRegList, U32 threadid)
 {
     int ret = -1;
 
+    ENTRY_POINT_ENTER(GET_THREAD_REG_LIST, threadid, 0u);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
         /* Look for the thread */
         nano_os_thread_t* const thread = findThread(threadid);
-        if ((thread != NULL) && (thread != nano_os_plugin.current_thread))
+        if ((thread != NULL) && (thread != nano_os_plugin.current_thread) && loadThreadDetails(thread))
         {
             /* Dump thread stack */
             bool success = dumpThreadStack(thread);
             if (success)
             {
-                /* Get the register list */
-                const nano_os_cpu_register_set_t* const cpu_reg_set = nano_os_plugin.cpu->registers_get(gdb_api, nano_os_plugin.port_name,
-                                                                                                        nano_os_plugin.target_current_thread_address + nano_os_plugin.offsets.task_port_data_offset);
+                /* Get the register list of the thread */
+                const nano_os_cpu_register_set_t* const cpu_reg_set = thread->cpu_reg_set;
                 if (cpu_reg_set != NULL)
                 {
                     /* Go through the whole register list */
@@ -623,7 +881,7 @@ EXPORT int RTOS_GetThreadRegList(char *pHexRegList, U32 threadid)
                     {
                         /* Compute value */
                         value = CPU_getRegValue(nano_os_plugin.cpu, &cpu_reg_set->registers[i],
-                                                thread->top_of_stack_without_stack_frame_address, thread->top_of_stack, value);
+                                                thread->top_of_stack_without_stack_frame_address, thread->stack + thread->top_of_stack_offset, value);
                     }
                 }
                 ret = 0;
@@ -631,6 +889,7 @@ EXPORT int RTOS_GetThreadRegList(char *pHexRegList, U32 threadid)
         }
     }
 
+    ENTRY_POINT_LEAVE(GET_THREAD_REG_LIST);
     return ret;
 }
 
@@ -641,6 +900,8 @@ EXPORT int RTOS_SetThreadReg(char* pHexRegVal, U32 RegIndex, U32 threadid)
 {
     int ret = -1;
 
+    ENTRY_POINT_ENTER(SET_THREAD_REG, RegIndex, threadid);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
@@ -654,6 +915,7 @@ EXPORT int RTOS_SetThreadReg(char* pHexRegVal, U32 RegIndex, U32 threadid)
         }
     }
 
+    ENTRY_POINT_LEAVE(SET_THREAD_REG);
     return ret;
 }
 
@@ -664,6 +926,8 @@ EXPORT int RTOS_SetThreadRegList(char *pHexRegList, U32 threadid)
 {
     int ret = -1;
 
+    ENTRY_POINT_ENTER(SET_THREAD_REG_LIST, threadid, 0u);
+
     /* Check OS state */
     if (nano_os_plugin.os_started)
     {
@@ -677,6 +941,7 @@ EXPORT int RTOS_SetThreadRegList(char *pHexRegList, U32 threadid)
         }
     }
 
+    ENTRY_POINT_LEAVE(SET_THREAD_REG_LIST);
     return ret;
 }
 
@@ -688,6 +953,12 @@ EXPORT int RTOS_UpdateThreads()
     int ret = -1;
     bool success;
 
+    ENTRY_POINT_ENTER(UPDATE_THREADS, 0u, 0u);
+
+    // Target memory may have changed since the last update
+    MEMCACHE_invalidate();
+    PROFILER_HALT();
+
     // Fill informations about Nano OS
     success = fillNanoOsOffsets();
     if (success && nano_os_plugin.offsets_loaded)
@@ -697,36 +968,121 @@ EXPORT int RTOS_UpdateThreads()
         {
             // Go through the OS thread list to refresh thread infos
             U32 thread_address = nano_os_plugin.target_thread_list_address;
+            U32 loop_check_address = thread_address;
+            U32 loop_check_index = 0u;
+            U32 loop_check_count = 1u;
+            bool loop = false;
+            const U32 previous_thread_count = nano_os_plugin.thread_count;
             nano_os_plugin.thread_count = 0u;
             nano_os_plugin.current_thread = NULL;
+
+            // Wait objects and saved contexts are stored in the transient memory of the update,
+            // the wait objects are read again and allocated along with the first thread
+            REGION_reset(&nano_os_plugin.region);
+            nano_os_plugin.wait_objects = NULL;
+            nano_os_plugin.wait_object_table = NULL;
+            nano_os_plugin.wait_object_capacity = 0u;
+            nano_os_plugin.wait_object_count = 0u;
+
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0)
+            // Threads are likely to be at the same addresses than at the previous update
+            prefetchThreads(previous_thread_count);
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0) */
+            indexSnapshots(previous_thread_count);
+            TRACE_BEGIN("walkThreadList");
             while (success && (thread_address != 0u))
             {
-                // Fill thread infos
-                success = fillNanoOsThreadInfos(thread_address, &nano_os_plugin.threads[nano_os_plugin.thread_count]);
+                // Make room for the thread, the list can't be longer than the thread id space
+                nano_os_thread_t* thread = NULL;
+                success = (nano_os_plugin.thread_count < NANO_OS_PLUGIN_MAX_THREAD_COUNT) && reserveThreads(nano_os_plugin.thread_count + 1u);
+                if (success)
+                {
+                    // Fill thread infos, unchanged threads are kept as is from the previous update
+                    thread = getThreadEntry(thread_address, nano_os_plugin.thread_count);
+                    thread->tcb_address = thread_address;
+
+                    // The saved context is outside of the task control block span, it may have changed
+                    // even if the task control block has not
+                    thread->stack_loaded = false;
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 1)
+                    // Only walk the list, details are loaded on first access
+                    success = fillNanoOsThreadLinks(thread_address, thread);
+#else
+                    success = fillNanoOsThreadInfos(thread_address, thread);
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 1) */
+                }
                 if (success)
                 {
                     // Check if this is the current running thread
                     if (thread_address == nano_os_plugin.target_current_thread_address)
                     {
-                        nano_os_plugin.current_thread = &nano_os_plugin.threads[nano_os_plugin.thread_count];
+                        nano_os_plugin.current_thread = thread;
                     }
 
                     // Next thread
-                    thread_address = nano_os_plugin.threads[nano_os_plugin.thread_count].next_thread;
+                    thread_address = thread->next_thread;
                     nano_os_plugin.thread_count++;
-                    if (nano_os_plugin.thread_count == NANO_OS_PLUGIN_MAX_THREAD_COUNT)
+
+                    // A corrupted list which loops comes back to the address saved at each power of 2 thread count
+                    if (thread_address == loop_check_address)
                     {
+                        loop = true;
                         success = false;
                     }
+                    else if (nano_os_plugin.thread_count == loop_check_count)
+                    {
+                        loop_check_address = thread_address;
+                        loop_check_index = nano_os_plugin.thread_count;
+                        loop_check_count *= 2u;
+                    }
+                }
+            }
+            TRACE_END("walkThreadList");
+
+            // The threads validated before a failure are kept, a looping list is cut before its first thread walked twice
+            if (!success)
+            {
+                if (loop)
+                {
+                    truncateThreadLoop(loop_check_index);
+                    LOG_WARNING("Nano-OS plugin: thread list loops at 0x%08x, only %u threads are listed\n", thread_address, nano_os_plugin.thread_count);
+                }
+                else
+                {
+                    LOG_WARNING("Nano-OS plugin: thread list unreadable at 0x%08x, only %u threads are listed\n", thread_address, nano_os_plugin.thread_count);
                 }
+                success = true;
             }
+
+            // Threads are looked up by id in all the other entry points
+            indexThreads();
+
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0)
+            // Read the wait objects and the saved contexts referenced by the threads
+            success = success && fillNanoOsDeferredInfos();
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0) */
             if (success)
             {
                 ret = 0;
             }
+
+            // Names which are not used anymore are dropped from the pool when it has grown
+            if (STRINGPOOL_getSize(&nano_os_plugin.names) > nano_os_plugin.names_rebuilt_size)
+            {
+                rebuildNames();
+            }
+            STATS_MAX(STATS_COUNTER_NAME_POOL_SIZE, STRINGPOOL_getSize(&nano_os_plugin.names));
+            STATS_MAX(STATS_COUNTER_TRANSIENT_MEMORY_PEAK, REGION_getPeakUsage(&nano_os_plugin.region));
+            STATS_MAX(STATS_COUNTER_TRANSIENT_MEMORY_SIZE, REGION_getSize(&nano_os_plugin.region));
         }
     }
 
+    ENTRY_POINT_LEAVE(UPDATE_THREADS);
+
+    // Write the trace and the recorded session of the update at once
+    TRACE_FLUSH();
+    RECORDER_FLUSH();
+
     return ret;
 }
 
@@ -740,34 +1096,164 @@ EXPORT int RTOS_UpdateThreads()
 **********************************************************************
 */
 
-/** \brief Read a string in target memory */
-static bool readString(const U32 string_address, char string[], const U32 string_size)
+/** \brief Read a string in target memory, or get it from the name cache (a cached name is checked against its first bytes if requested) */
+static bool readString(const U32 string_content_address, const bool check, U32* const name)
 {
     int err;
     bool ret = true;
+    U32 string_bytes;
+    char string[NANO_OS_PLUGIN_MAX_STRING_LENGTH + 1u];
+
+    TRACE_BEGIN(__func__);
+    PROFILER_SITE(PROFILER_SITE_NAME);
+
+    /* Read the whole string */
+    (*name) = STRINGPOOL_EMPTY;
+    if (string_content_address != 0u)
+    {
+        /* Names are cached by address across the halts until the target is reset */
+        const U32 read_bytes = STATS_getReadBytes();
+        bool cached = (!check && NAMECACHE_find(string_content_address, name));
+        if (!cached)
+        {
+            U32 length = 0u;
+            U32 prefix_size = 0u;
+            bool terminated = false;
+            bool unmapped = false;
+
+            /* Read the string up to the end of each page of the memory cache until the null terminator is found,
+               so that the following page is fetched only if the string spans it */
+            while (!terminated && !unmapped && !cached && (length < NANO_OS_PLUGIN_MAX_STRING_LENGTH))
+            {
+                const U32 chunk_address = string_content_address + length;
+                U32 read_size = MEMCACHE_PAGE_SIZE - (chunk_address % MEMCACHE_PAGE_SIZE);
+                if (read_size > (NANO_OS_PLUGIN_MAX_STRING_LENGTH - length))
+                {
+                    read_size = NANO_OS_PLUGIN_MAX_STRING_LENGTH - length;
+                }
+                err = gdb_api->pfReadMem(chunk_address, &string[length], read_size);
+                if (err != 0)
+                {
+                    terminated = (memchr(&string[length], 0, read_size) != NULL);
+                    length += read_size;
+                    if (prefix_size == 0u)
+                    {
+                        /* A name built in RAM may have been rebuilt at the same address, the cached one is kept if its first bytes have not changed */
+                        prefix_size = ((read_size < NAMECACHE_PREFIX_SIZE) ? read_size : NAMECACHE_PREFIX_SIZE);
+                        cached = (check && NAMECACHE_check(string_content_address, string, prefix_size, name));
+                    }
+                }
+                else
+                {
+                    /* Unmapped memory, keep the part of the string which has already been read */
+                    ret = (length != 0u);
+                    unmapped = true;
+                }
+            }
+            if (!cached)
+            {
+                string[length] = 0;
+
+                /* Names shared by several threads or wait objects are stored once */
+                if (!STRINGPOOL_intern(&nano_os_plugin.names, gdb_api, string, name))
+                {
+                    LOG_ERROR("Unable to store the name at 0x%08x\n", string_content_address);
+                    ret = false;
+                }
+
+                /* Truncated names are read again at the next update */
+                if (ret && terminated)
+                {
+                    NAMECACHE_add(string_content_address, (*name), string, prefix_size);
+                }
+            }
+        }
+
+        /* Compare the bytes read through the GDB server with a read of the maximum string size */
+        string_bytes = STATS_getReadBytes() - read_bytes;
+        STATS_ADD(STATS_COUNTER_STRING_BYTES, string_bytes);
+        STATS_ADD(STATS_COUNTER_STRING_BYTES_SAVED, ((string_bytes < (NANO_OS_PLUGIN_MAX_STRING_LENGTH + 1u)) ? (NANO_OS_PLUGIN_MAX_STRING_LENGTH + 1u - string_bytes) : 0u));
+    }
+
+    TRACE_END(__func__);
+    return ret;
+}
+
+/** \brief Forget all the names read from the target */
+static void invalidateNames(void)
+{
+    U32 i;
+
+    NAMECACHE_invalidate();
+    STRINGPOOL_reset(&nano_os_plugin.names);
+    nano_os_plugin.names_rebuilt_size = 0u;
+
+    /* The snapshots are decoded again with their new names */
+    for (i = 0u; i < nano_os_plugin.thread_count; i++)
+    {
+        nano_os_plugin.threads[i].address = 0u;
+        nano_os_plugin.threads[i].name = STRINGPOOL_EMPTY;
+    }
+    for (i = 0u; i < nano_os_plugin.wait_object_count; i++)
+    {
+        nano_os_plugin.wait_objects[i].name = STRINGPOOL_EMPTY;
+    }
+}
+
+/** \brief Rebuild the name pool with only the names still used by the threads and the wait objects */
+static void rebuildNames(void)
+{
+    U32 i;
+    bool ret = true;
+    stringpool_t names;
+
+    TRACE_BEGIN(__func__);
+
+    /* Copy the names still in use to a new pool, the current pool is kept if the new one can't grow */
+    memset(&names, 0, sizeof(stringpool_t));
+    for (i = 0u; (i < nano_os_plugin.thread_count) && ret; i++)
+    {
+        U32 name;
+        ret = STRINGPOOL_intern(&names, gdb_api, STRINGPOOL_get(&nano_os_plugin.names, nano_os_plugin.threads[i].name), &name);
+    }
+    for (i = 0u; (i < nano_os_plugin.wait_object_count) && ret; i++)
+    {
+        U32 name;
+        ret = STRINGPOOL_intern(&names, gdb_api, STRINGPOOL_get(&nano_os_plugin.names, nano_os_plugin.wait_objects[i].name), &name);
+    }
 
-    /* Read the string content address */
-    U32 string_content_address = 0u;
-    err = gdb_api->pfReadU32(string_address, &string_content_address);
-    ret = ret && (err == 0);
     if (ret)
     {
-        /* Read the whole string */
-        if (string_content_address != 0u)
+        /* Move the handles to the new pool */
+        for (i = 0u; i < nano_os_plugin.thread_count; i++)
         {
-            err = gdb_api->pfReadMem(string_content_address, string, string_size);
-            ret = ret && (err != 0);
+            nano_os_thread_t* const thread = &nano_os_plugin.threads[i];
+            (void)STRINGPOOL_find(&names, STRINGPOOL_get(&nano_os_plugin.names, thread->name), &thread->name);
         }
-        else
+        for (i = 0u; i < nano_os_plugin.wait_object_count; i++)
         {
-            strcpy(string, "");
+            nano_os_wait_object_t* const wait_object = &nano_os_plugin.wait_objects[i];
+            (void)STRINGPOOL_find(&names, STRINGPOOL_get(&nano_os_plugin.names, wait_object->name), &wait_object->name);
         }
-    }
+        NAMECACHE_rebuild(&nano_os_plugin.names, &names);
 
-    /* Terminate string */
-    string[string_size - 1u] = 0;
+        /* The snapshots after the thread list are not reused, their names are not valid anymore */
+        for (i = nano_os_plugin.thread_count; i < nano_os_plugin.thread_capacity; i++)
+        {
+            nano_os_plugin.threads[i].address = 0u;
+            nano_os_plugin.threads[i].name = STRINGPOOL_EMPTY;
+        }
 
-    return ret;
+        STRINGPOOL_release(&nano_os_plugin.names, gdb_api);
+        memcpy(&nano_os_plugin.names, &names, sizeof(stringpool_t));
+    }
+    else
+    {
+        STRINGPOOL_release(&names, gdb_api);
+    }
+    nano_os_plugin.names_rebuilt_size = STRINGPOOL_getSize(&nano_os_plugin.names);
+
+    TRACE_END(__func__);
 }
 
 
@@ -777,17 +1263,204 @@ static nano_os_thread_t* findThread(const U32 id)
     U32 index;
     nano_os_thread_t* thread = NULL;
 
-    for (index = 0u; (index < nano_os_plugin.thread_count) && (thread == NULL); index++)
+    if (id < nano_os_plugin.thread_id_index_size)
+    {
+        /* The entries of the threads which are gone are not removed from the index */
+        index = nano_os_plugin.thread_id_index[id];
+        if ((index != 0u) && (index <= nano_os_plugin.thread_count) && (nano_os_plugin.threads[index - 1u].id == id))
+        {
+            thread = &nano_os_plugin.threads[index - 1u];
+        }
+    }
+    else
     {
-        if (nano_os_plugin.threads[index].id == id)
+        /* Ids which could not be indexed */
+        for (index = 0u; (index < nano_os_plugin.thread_count) && (thread == NULL); index++)
         {
-            thread = &nano_os_plugin.threads[index];
+            if (nano_os_plugin.threads[index].id == id)
+            {
+                thread = &nano_os_plugin.threads[index];
+            }
         }
     }
 
     return thread;
 }
 
+/** \brief Get the buffers of a thread */
+static nano_os_thread_data_t* getThreadData(const nano_os_thread_t* const thread)
+{
+    return &nano_os_plugin.thread_data[thread - nano_os_plugin.threads];
+}
+
+/** \brief Release the thread list, the wait objects, their lookup tables and the names */
+static void releaseThreads(void)
+{
+    if (nano_os_plugin.threads != NULL)
+    {
+        gdb_api->pfFree(nano_os_plugin.threads);
+    }
+    if (nano_os_plugin.thread_data != NULL)
+    {
+        gdb_api->pfFree(nano_os_plugin.thread_data);
+    }
+    if (nano_os_plugin.thread_id_index != NULL)
+    {
+        gdb_api->pfFree(nano_os_plugin.thread_id_index);
+    }
+    REGION_release(&nano_os_plugin.region, gdb_api);
+    STRINGPOOL_release(&nano_os_plugin.names, gdb_api);
+    nano_os_plugin.threads = NULL;
+    nano_os_plugin.thread_data = NULL;
+    nano_os_plugin.wait_objects = NULL;
+    nano_os_plugin.wait_object_table = NULL;
+    nano_os_plugin.thread_id_index = NULL;
+    nano_os_plugin.thread_capacity = 0u;
+    nano_os_plugin.thread_id_index_size = 0u;
+    nano_os_plugin.thread_count = 0u;
+    nano_os_plugin.wait_object_capacity = 0u;
+    nano_os_plugin.wait_object_count = 0u;
+    nano_os_plugin.current_thread = NULL;
+}
+
+/** \brief Make room for the given number of threads in the thread list and the wait objects */
+static bool reserveThreads(const U32 thread_count)
+{
+    bool ret = true;
+
+    if (thread_count > nano_os_plugin.thread_capacity)
+    {
+        U32 capacity = ((nano_os_plugin.thread_capacity != 0u) ? nano_os_plugin.thread_capacity : NANO_OS_PLUGIN_MIN_THREAD_CAPACITY);
+        const U32 current_thread_index = ((nano_os_plugin.current_thread != NULL) ? (U32)(nano_os_plugin.current_thread - nano_os_plugin.threads) : 0u);
+        nano_os_thread_data_t* thread_data = NULL;
+        nano_os_thread_t* threads;
+        while (capacity < thread_count)
+        {
+            capacity *= 2u;
+        }
+
+        threads = (nano_os_thread_t*)gdb_api->pfRealloc(nano_os_plugin.threads, capacity * sizeof(nano_os_thread_t));
+        if (threads != NULL)
+        {
+            if (nano_os_plugin.current_thread != NULL)
+            {
+                nano_os_plugin.current_thread = &threads[current_thread_index];
+            }
+            nano_os_plugin.threads = threads;
+            thread_data = (nano_os_thread_data_t*)gdb_api->pfRealloc(nano_os_plugin.thread_data, capacity * sizeof(nano_os_thread_data_t));
+        }
+        if (thread_data != NULL)
+        {
+            const U32 previous_capacity = nano_os_plugin.thread_capacity;
+            memset(&threads[previous_capacity], 0, (capacity - previous_capacity) * sizeof(nano_os_thread_t));
+            memset(&thread_data[previous_capacity], 0, (capacity - previous_capacity) * sizeof(nano_os_thread_data_t));
+            nano_os_plugin.thread_data = thread_data;
+            nano_os_plugin.thread_capacity = capacity;
+        }
+        else
+        {
+            LOG_ERROR("Unable to allocate %u threads\n", capacity);
+            ret = false;
+        }
+    }
+
+    /* A thread waits on at most one object, the wait objects are allocated along with the threads */
+    if (ret && (thread_count > nano_os_plugin.wait_object_capacity))
+    {
+        ret = allocateWaitObjects(nano_os_plugin.thread_capacity);
+    }
+
+    return ret;
+}
+
+/** \brief Allocate the wait objects of the current update, the wait objects already registered are moved */
+static bool allocateWaitObjects(const U32 capacity)
+{
+    bool ret = false;
+    region_t* const region = &nano_os_plugin.region;
+    nano_os_wait_object_t* const wait_objects = (nano_os_wait_object_t*)REGION_alloc(region, gdb_api, capacity * sizeof(nano_os_wait_object_t));
+    U32* const wait_object_table = (U32*)REGION_alloc(region, gdb_api, 2u * capacity * sizeof(U32));
+
+    if ((wait_objects != NULL) && (wait_object_table != NULL))
+    {
+        U32 i;
+        nano_os_wait_object_t* const previous_wait_objects = nano_os_plugin.wait_objects;
+        if (nano_os_plugin.wait_object_count != 0u)
+        {
+            /* Relocate the pointers of the threads already decoded to their wait object */
+            memcpy(wait_objects, previous_wait_objects, nano_os_plugin.wait_object_count * sizeof(nano_os_wait_object_t));
+            for (i = 0u; i < nano_os_plugin.thread_count; i++)
+            {
+                nano_os_thread_t* const thread = &nano_os_plugin.threads[i];
+                if (thread->details_loaded && (thread->wait_object != NULL))
+                {
+                    thread->wait_object = wait_objects + (thread->wait_object - previous_wait_objects);
+                }
+            }
+        }
+        nano_os_plugin.wait_objects = wait_objects;
+        nano_os_plugin.wait_object_table = wait_object_table;
+        nano_os_plugin.wait_object_capacity = capacity;
+
+        /* Register again the wait objects of the current update */
+        memset(wait_object_table, 0, 2u * capacity * sizeof(U32));
+        for (i = 0u; i < nano_os_plugin.wait_object_count; i++)
+        {
+            wait_object_table[findWaitObjectSlot(wait_objects[i].address)] = i + 1u;
+        }
+        ret = true;
+    }
+    else
+    {
+        LOG_ERROR("Unable to allocate %u wait objects\n", capacity);
+    }
+
+    return ret;
+}
+
+/** \brief Update the thread id index with the threads found during the last update */
+static void indexThreads(void)
+{
+    U32 i;
+
+    TRACE_BEGIN(__func__);
+
+    for (i = 0u; i < nano_os_plugin.thread_count; i++)
+    {
+        const U16 id = nano_os_plugin.threads[i].id;
+
+        /* Extend the index up to the thread id */
+        if (id >= nano_os_plugin.thread_id_index_size)
+        {
+            U32 size = ((nano_os_plugin.thread_id_index_size != 0u) ? nano_os_plugin.thread_id_index_size : NANO_OS_PLUGIN_MIN_THREAD_ID_INDEX_SIZE);
+            U32* thread_id_index;
+            while (size <= id)
+            {
+                size *= 2u;
+            }
+            thread_id_index = (U32*)gdb_api->pfRealloc(nano_os_plugin.thread_id_index, size * sizeof(U32));
+            if (thread_id_index != NULL)
+            {
+                memset(&thread_id_index[nano_os_plugin.thread_id_index_size], 0, (size - nano_os_plugin.thread_id_index_size) * sizeof(U32));
+                nano_os_plugin.thread_id_index = thread_id_index;
+                nano_os_plugin.thread_id_index_size = size;
+            }
+        }
+
+        /* Only the entries which don't point to the first thread with this id anymore are updated */
+        if (id < nano_os_plugin.thread_id_index_size)
+        {
+            const U32 index = nano_os_plugin.thread_id_index[id];
+            if ((index == 0u) || (index > (i + 1u)) || (nano_os_plugin.threads[index - 1u].id != id))
+            {
+                nano_os_plugin.thread_id_index[id] = i + 1u;
+            }
+        }
+    }
+
+    TRACE_END(__func__);
+}
+
 /** \brief Macro to read 8 bits data structure offsets */
 #define READ_DATA_STRUCTURE_OFFSET8(value)  err = gdb_api->pfReadU8(nano_os_symbols[1u].address + offset, &nano_os_plugin.offsets.value); \
                                             ret = ret && (err == 0); \
@@ -809,6 +1482,9 @@ static bool fillNanoOsOffsets(void)
 {
     bool ret = true;
 
+    TRACE_BEGIN(__func__);
+    PROFILER_SITE(PROFILER_SITE_OFFSETS);
+
     /* CHeck if the offsets have already been loaded */
     if (!nano_os_plugin.offsets_loaded)
     {
@@ -854,20 +1530,94 @@ static bool fillNanoOsOffsets(void)
                 nano_os_plugin.offsets_loaded = true;
             }
 
-            
+            /* Compute the task control block and wait object spans to read */
+            computeTaskSpan();
+            computeWaitObjectSpan();
         }
     }
 
+    TRACE_END(__func__);
     return ret;
 }
 
 
+/** \brief Macro to extend a data structure span with a field */
+#define EXTEND_SPAN(field_offset, field_size)       if ((field_offset) < span_start) \
+                                                    { \
+                                                        span_start = (field_offset); \
+                                                    } \
+                                                    if (((U16)(field_offset) + (field_size)) > span_end) \
+                                                    { \
+                                                        span_end = (U16)(field_offset) + (field_size); \
+                                                    }
+
+/** \brief Compute the task control block span covering all the decoded fields */
+static void computeTaskSpan(void)
+{
+    U8 span_start = NANO_OS_PLUGIN_INVALID_OFFSET8;
+    U16 span_end = 0u;
+    const nano_os_data_structure_offsets_t* const offsets = &nano_os_plugin.offsets;
+
+    /* Go through all the fields decoded in fillNanoOsThreadInfos() */
+    EXTEND_SPAN(offsets->task_id_offset, 2u);
+    if (offsets->task_name_offset != NANO_OS_PLUGIN_INVALID_OFFSET8)
+    {
+        EXTEND_SPAN(offsets->task_name_offset, 4u);
+    }
+    EXTEND_SPAN(offsets->task_state_offset, 1u);
+    EXTEND_SPAN(offsets->task_priority_offset, 1u);
+    EXTEND_SPAN(offsets->top_of_stack_offset, 4u);
+    EXTEND_SPAN(offsets->stack_size_offset, 4u);
+    EXTEND_SPAN(offsets->task_wait_object_offset, 4u);
+    EXTEND_SPAN(offsets->task_wait_timeout_offset, 4u);
+    EXTEND_SPAN(offsets->next_task_offset, 4u);
+    if (nano_os_plugin.cpu->task_port_data_size != 0u)
+    {
+        EXTEND_SPAN(offsets->task_port_data_offset, nano_os_plugin.cpu->task_port_data_size);
+    }
+
+    nano_os_plugin.task_span_start = span_start;
+    nano_os_plugin.task_span_size = span_end - span_start;
+
+    /* Only the thread id and the next task address are needed to walk the thread list */
+    span_start = NANO_OS_PLUGIN_INVALID_OFFSET8;
+    span_end = 0u;
+    EXTEND_SPAN(offsets->task_id_offset, 2u);
+    EXTEND_SPAN(offsets->next_task_offset, 4u);
+
+    nano_os_plugin.task_link_span_start = span_start;
+    nano_os_plugin.task_link_span_size = span_end - span_start;
+}
+
+/** \brief Compute the wait object span covering all the decoded fields */
+static void computeWaitObjectSpan(void)
+{
+    U8 span_start = NANO_OS_PLUGIN_INVALID_OFFSET8;
+    U16 span_end = 0u;
+    const nano_os_data_structure_offsets_t* const offsets = &nano_os_plugin.offsets;
+
+    /* Go through all the fields decoded in fillNanoOsWaitObjectInfos() */
+    EXTEND_SPAN(offsets->wait_object_id_offset, 2u);
+    if (offsets->wait_object_name_offset != NANO_OS_PLUGIN_INVALID_OFFSET8)
+    {
+        EXTEND_SPAN(offsets->wait_object_name_offset, 4u);
+    }
+    EXTEND_SPAN(offsets->wait_object_type_offset, 1u);
+
+    nano_os_plugin.wait_object_span_start = span_start;
+    nano_os_plugin.wait_object_span_size = span_end - span_start;
+}
+
+
 /** \brief Fill informations about Nano OS */
 static bool fillNanoOsInfos(void)
 {
     int err;
     bool ret = true;
 
+    TRACE_BEGIN(__func__);
+    PROFILER_SITE(PROFILER_SITE_OS_INFOS);
+
     /* Read the current thread address */
     err = gdb_api->pfReadU32(nano_os_symbols[0u].address + nano_os_plugin.offsets.current_task_offset, &nano_os_plugin.target_current_thread_address);
     ret = ret && (err == 0);
@@ -875,6 +1625,15 @@ static bool fillNanoOsInfos(void)
     {
         nano_os_plugin.os_started = true;
     }
+    else if (ret && nano_os_plugin.os_started)
+    {
+        /* The target has been reset, the firmware may have been reflashed */
+        invalidateNames();
+        nano_os_plugin.os_started = false;
+
+        /* The debug session is over, the next one starts with the new firmware */
+        STATS_END_SESSION();
+    }
     
     /* Read the thread list address */
     err = gdb_api->pfReadU32(nano_os_symbols[0u].address + nano_os_plugin.offsets.task_list_offset, &nano_os_plugin.target_thread_list_address);
@@ -884,149 +1643,522 @@ static bool fillNanoOsInfos(void)
     err = gdb_api->pfReadU32(nano_os_symbols[0u].address + nano_os_plugin.offsets.tick_count_offset, &nano_os_plugin.tick_count);
     ret = ret && (err == 0);
 
+    TRACE_END(__func__);
     return ret;
 }
 
 
-/** \brief Fill a thread information */
-static bool fillNanoOsThreadInfos(const U32 thread_address, nano_os_thread_t* const thread)
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0)
+
+/** \brief Prefetch the task control blocks of the threads known from the previous update */
+static void prefetchThreads(const U32 previous_thread_count)
 {
-    int err;
-    bool ret = true;
-    const nano_os_cpu_register_set_t* cpu_reg_set;
+    U32 i;
+    U32 transfer_count;
 
-    /* Read the thread id */
-    err = gdb_api->pfReadU16(thread_address + nano_os_plugin.offsets.task_id_offset, &thread->id);
-    ret = ret && (err == 0);
+    TRACE_BEGIN(__func__);
+    PROFILER_SITE(PROFILER_SITE_TCB);
 
-    /* Read the thread name */
-    if (nano_os_plugin.offsets.task_name_offset == NANO_OS_PLUGIN_INVALID_OFFSET8)
+    READPLAN_reset();
+    for (i = 0u; i < previous_thread_count; i++)
     {
-        strcpy(thread->name, "Unknown task");
+        nano_os_thread_t* const thread = &nano_os_plugin.threads[i];
+        thread->tcb_prefetched = false;
+        if (thread->address != 0u)
+        {
+            /* Threads which can't be planned will be read during the thread list walk */
+            (void)READPLAN_add(thread->address + nano_os_plugin.task_span_start, nano_os_plugin.task_span_size, getThreadData(thread)->prefetched_tcb, &thread->tcb_prefetched);
+        }
     }
-    else
+    transfer_count = READPLAN_execute(gdb_api, NANO_OS_PLUGIN_READ_PLAN_MAX_GAP);
+    STATS_ADD(STATS_COUNTER_TCB_PREFETCH_TRANSFERS, transfer_count);
+
+    TRACE_END(__func__);
+}
+
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0) */
+
+/** \brief Build the lookup table of the thread snapshots of the previous update */
+static void indexSnapshots(const U32 previous_thread_count)
+{
+    U32 i;
+    U32 size = NANO_OS_PLUGIN_MIN_THREAD_CAPACITY;
+
+    TRACE_BEGIN(__func__);
+
+    /* The snapshots are decoded again if the table can't be allocated */
+    while (size < (2u * previous_thread_count))
     {
-        ret = readString(thread_address + nano_os_plugin.offsets.task_name_offset, thread->name, sizeof(thread->name));
+        size *= 2u;
+    }
+    nano_os_plugin.snapshot_table = (nano_os_snapshot_slot_t*)REGION_alloc(&nano_os_plugin.region, gdb_api, size * sizeof(nano_os_snapshot_slot_t));
+    nano_os_plugin.snapshot_table_size = ((nano_os_plugin.snapshot_table != NULL) ? size : 0u);
+    nano_os_plugin.snapshot_end = previous_thread_count;
+    if (nano_os_plugin.snapshot_table != NULL)
+    {
+        memset(nano_os_plugin.snapshot_table, 0, size * sizeof(nano_os_snapshot_slot_t));
+        for (i = 0u; i < previous_thread_count; i++)
+        {
+            const U32 address = nano_os_plugin.threads[i].address;
+            if (address != 0u)
+            {
+                nano_os_snapshot_slot_t* const slot = &nano_os_plugin.snapshot_table[findSnapshotSlot(address)];
+                if (slot->address == 0u)
+                {
+                    slot->address = address;
+                    slot->index = i;
+                }
+            }
+        }
     }
 
-    /* Read the thread state */
-    err = gdb_api->pfReadU8(thread_address + nano_os_plugin.offsets.task_state_offset, &thread->state);
-    ret = ret && (err == 0);
+    TRACE_END(__func__);
+}
 
-    /* Read the thread priority */
-    err = gdb_api->pfReadU8(thread_address + nano_os_plugin.offsets.task_priority_offset, &thread->priority);
-    ret = ret && (err == 0);
+/** \brief Get the slot of a thread snapshot in the lookup table, or the free slot where to register it */
+static U32 findSnapshotSlot(const U32 thread_address)
+{
+    const U32 mask = nano_os_plugin.snapshot_table_size - 1u;
+    U32 slot = ((thread_address * 2654435761u) >> 16u) & mask;
 
-    /* Read top of stack address */
-    err = gdb_api->pfReadU32(thread_address + nano_os_plugin.offsets.top_of_stack_offset, &thread->top_of_stack_address);
-    ret = ret && (err == 0);
+    while ((nano_os_plugin.snapshot_table[slot].address != 0u) && (nano_os_plugin.snapshot_table[slot].address != thread_address))
+    {
+        slot = (slot + 1u) & mask;
+    }
+
+    return slot;
+}
+
+/** \brief Get the thread entry to refresh, reusing the previous snapshot of the thread if any */
+static nano_os_thread_t* getThreadEntry(const U32 thread_address, const U32 index)
+{
+    nano_os_snapshot_slot_t* snapshot = NULL;
+    nano_os_snapshot_slot_t* occupant = NULL;
+    const U32 occupant_address = nano_os_plugin.threads[index].address;
 
-    /* Compute stack frame size for the selected CPU */
-    cpu_reg_set = nano_os_plugin.cpu->registers_get(gdb_api, nano_os_plugin.port_name,
-                                                    nano_os_plugin.target_current_thread_address + nano_os_plugin.offsets.task_port_data_offset);
-    if (cpu_reg_set != NULL)
+    if (nano_os_plugin.snapshot_table_size != 0u)
     {
-        nano_os_plugin.cpu_stack_frame_size = CPU_computeStackFrameSize(cpu_reg_set);
+        /* Look for the previous snapshot of the thread, the entries before the index have already been refreshed */
+        snapshot = &nano_os_plugin.snapshot_table[findSnapshotSlot(thread_address)];
+        if ((snapshot->address == 0u) || (snapshot->index < index) || (nano_os_plugin.threads[snapshot->index].address != thread_address))
+        {
+            snapshot = NULL;
+        }
+
+        /* Look for the previous snapshot held by the entry */
+        if ((index < nano_os_plugin.snapshot_end) && (occupant_address != 0u) && (occupant_address != thread_address))
+        {
+            occupant = &nano_os_plugin.snapshot_table[findSnapshotSlot(occupant_address)];
+            if ((occupant->address == 0u) || (occupant->index != index))
+            {
+                occupant = NULL;
+            }
+        }
+    }
 
-        /* Compute top of stack address before context saving */
-        thread->top_of_stack_without_stack_frame_address = thread->top_of_stack_address - nano_os_plugin.cpu->stack_growth_dir * nano_os_plugin.cpu_stack_frame_size;
+    if (snapshot != NULL)
+    {
+        if (snapshot->index != index)
+        {
+            /* Swap the entries so that the snapshot held by the entry stays available */
+            nano_os_thread_t temp_thread;
+            nano_os_thread_data_t temp_thread_data;
+            nano_os_thread_t* const thread = &nano_os_plugin.threads[index];
+            nano_os_thread_t* const previous_thread = &nano_os_plugin.threads[snapshot->index];
+            nano_os_thread_data_t* const thread_data = getThreadData(thread);
+            nano_os_thread_data_t* const previous_thread_data = getThreadData(previous_thread);
+            memcpy(&temp_thread, thread, sizeof(nano_os_thread_t));
+            memcpy(thread, previous_thread, sizeof(nano_os_thread_t));
+            memcpy(previous_thread, &temp_thread, sizeof(nano_os_thread_t));
+            memcpy(&temp_thread_data, thread_data, sizeof(nano_os_thread_data_t));
+            memcpy(thread_data, previous_thread_data, sizeof(nano_os_thread_data_t));
+            memcpy(previous_thread_data, &temp_thread_data, sizeof(nano_os_thread_data_t));
+            if (occupant != NULL)
+            {
+                occupant->index = snapshot->index;
+            }
+            snapshot->index = index;
+        }
     }
     else
     {
-        ret = false;
+        /* New thread, the snapshot held by the entry is moved after the other snapshots (it is lost if there is no room) */
+        if ((occupant != NULL) && reserveThreads(nano_os_plugin.snapshot_end + 1u))
+        {
+            memcpy(&nano_os_plugin.threads[nano_os_plugin.snapshot_end], &nano_os_plugin.threads[index], sizeof(nano_os_thread_t));
+            memcpy(&nano_os_plugin.thread_data[nano_os_plugin.snapshot_end], &nano_os_plugin.thread_data[index], sizeof(nano_os_thread_data_t));
+            occupant->index = nano_os_plugin.snapshot_end;
+            nano_os_plugin.snapshot_end++;
+        }
+        nano_os_plugin.threads[index].address = 0u;
     }
 
-    /* Read the stack size */
-    err = gdb_api->pfReadU32(thread_address + nano_os_plugin.offsets.stack_size_offset, &thread->stack_size);
-    ret = ret && (err == 0);
+    return &nano_os_plugin.threads[index];
+}
 
-    /* Delay stack load */
-    thread->stack_loaded = false;
+/** \brief Cut a looping thread list before its first thread walked twice, given the index of a thread inside the loop
+           which is found again after the last thread of the list */
+static void truncateThreadLoop(const U32 loop_index)
+{
+    U32 i;
+    const U32 loop_length = nano_os_plugin.thread_count - loop_index;
 
-    /* Read the wait object */
-    U32 wait_object_address = 0u;
-    err = gdb_api->pfReadU32(thread_address + nano_os_plugin.offsets.task_wait_object_offset, &wait_object_address);
-    ret = ret && (err == 0);
-    if (wait_object_address != 0u)
+    /* The loop starts at the first thread which is found again one loop length later */
+    i = 0u;
+    while ((i < loop_index) && (nano_os_plugin.threads[i].tcb_address != nano_os_plugin.threads[i + loop_length].tcb_address))
+    {
+        i++;
+    }
+    nano_os_plugin.thread_count = i + loop_length;
+
+    /* The running thread may have been found again after the cut */
+    nano_os_plugin.current_thread = NULL;
+    for (i = 0u; i < nano_os_plugin.thread_count; i++)
+    {
+        if (nano_os_plugin.threads[i].tcb_address == nano_os_plugin.target_current_thread_address)
+        {
+            nano_os_plugin.current_thread = &nano_os_plugin.threads[i];
+        }
+    }
+}
+
+/** \brief Macro to get a pointer to a field inside a task control block read in one transfer */
+#define TCB_FIELD(tcb, field_offset)    (&(tcb)[nano_os_plugin.offsets.field_offset - nano_os_plugin.task_span_start])
+
+/** \brief Fill a thread information */
+static bool fillNanoOsThreadInfos(const U32 thread_address, nano_os_thread_t* const thread)
+{
+    int err;
+    bool ret = true;
+    U8 tcb[NANO_OS_PLUGIN_MAX_TCB_SPAN_SIZE];
+    nano_os_thread_data_t* const thread_data = getThreadData(thread);
+
+    /* Read all the needed fields of the task control block at once, unless they have been prefetched */
+    if ((thread->address == thread_address) && thread->tcb_prefetched)
     {
-        ret = fillNanoOsWaitObjectInfos(wait_object_address, &thread->wait_object);
+        memcpy(tcb, thread_data->prefetched_tcb, nano_os_plugin.task_span_size);
     }
     else
     {
-        memset(&thread->wait_object, 0, sizeof(nano_os_wait_object_t));
+        PROFILER_SITE(PROFILER_SITE_TCB);
+        err = gdb_api->pfReadMem(thread_address + nano_os_plugin.task_span_start, (char*)tcb, nano_os_plugin.task_span_size);
+        ret = ret && (err != 0);
     }
+    thread->tcb_prefetched = false;
 
-    /* Read the wait timeout */
-    err = gdb_api->pfReadU32(thread_address + nano_os_plugin.offsets.task_wait_timeout_offset, &thread->wait_timeout);
-    ret = ret && (err == 0);
+    /* Decode the thread only if it has changed since the previous update */
+    if (ret && ((thread->address != thread_address) || (memcmp(thread_data->tcb, tcb, nano_os_plugin.task_span_size) != 0)))
+    {
+        /* Decode the thread id */
+        thread->id = (U16)gdb_api->pfLoad16TE(TCB_FIELD(tcb, task_id_offset));
+
+        /* Read the thread name */
+        if (nano_os_plugin.offsets.task_name_offset == NANO_OS_PLUGIN_INVALID_OFFSET8)
+        {
+            ret = STRINGPOOL_intern(&nano_os_plugin.names, gdb_api, "Unknown task", &thread->name);
+        }
+        else
+        {
+            ret = readString(gdb_api->pfLoad32TE(TCB_FIELD(tcb, task_name_offset)), true, &thread->name);
+        }
+
+        /* Decode the thread state */
+        thread->state = *TCB_FIELD(tcb, task_state_offset);
+
+        /* Decode the thread priority */
+        thread->priority = *TCB_FIELD(tcb, task_priority_offset);
+
+        /* Decode top of stack address */
+        thread->top_of_stack_address = gdb_api->pfLoad32TE(TCB_FIELD(tcb, top_of_stack_offset));
+
+        /* Decode the stack size */
+        thread->stack_size = gdb_api->pfLoad32TE(TCB_FIELD(tcb, stack_size_offset));
+
+        /* Select the saved registers from the port specific data (floating point context) */
+        thread->cpu_reg_set = nano_os_plugin.cpu->registers_get(nano_os_plugin.port_name,
+                                                                ((nano_os_plugin.cpu->task_port_data_size != 0u) ? TCB_FIELD(tcb, task_port_data_offset) : NULL));
+        if (thread->cpu_reg_set != NULL)
+        {
+            thread->stack_frame_size = CPU_computeStackFrameSize(thread->cpu_reg_set);
+        }
+        else
+        {
+            ret = false;
+        }
+
+        /* Decode the wait object address */
+        thread->wait_object_address = gdb_api->pfLoad32TE(TCB_FIELD(tcb, task_wait_object_offset));
+
+        /* Decode the wait timeout */
+        thread->wait_timeout = gdb_api->pfLoad32TE(TCB_FIELD(tcb, task_wait_timeout_offset));
+
+        /* Decode the next task address */
+        thread->next_thread = gdb_api->pfLoad32TE(TCB_FIELD(tcb, next_task_offset));
+
+        /* Save the snapshot only if it has been fully decoded */
+        if (ret)
+        {
+            thread->address = thread_address;
+            memcpy(thread_data->tcb, tcb, nano_os_plugin.task_span_size);
+        }
+        else
+        {
+            thread->address = 0u;
+        }
+    }
+
+    /* Compute top of stack address before context saving */
+    thread->top_of_stack_without_stack_frame_address = thread->top_of_stack_address - nano_os_plugin.cpu->stack_growth_dir * thread->stack_frame_size;
+
+    /* Get the wait object, shared with all the other threads waiting on it */
+    thread->wait_object = NULL;
+    if (ret && (thread->wait_object_address != 0u))
+    {
+        thread->wait_object = getWaitObject(thread->wait_object_address);
+        ret = (thread->wait_object != NULL);
+    }
+    thread->details_loaded = ret;
 
-    /* Read the next task address */
-    err = gdb_api->pfReadU32(thread_address + nano_os_plugin.offsets.next_task_offset, &thread->next_thread);
-    ret = ret && (err == 0);
-    
     return ret;
 }
 
-/** \brief Fill a wait object information */
-static bool fillNanoOsWaitObjectInfos(const U32 wait_object_address, nano_os_wait_object_t* const wait_object)
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 1)
+
+/** \brief Macro to get a pointer to a field inside the task control block links read in one transfer */
+#define TCB_LINK_FIELD(data, field_offset)  (&(data)[nano_os_plugin.offsets.field_offset - nano_os_plugin.task_link_span_start])
+
+/** \brief Fill the thread information needed to walk the thread list */
+static bool fillNanoOsThreadLinks(const U32 thread_address, nano_os_thread_t* const thread)
 {
     int err;
     bool ret = true;
+    U8 data[NANO_OS_PLUGIN_MAX_TCB_SPAN_SIZE];
 
-    /* Read the id */
-    err = gdb_api->pfReadU16(wait_object_address + nano_os_plugin.offsets.wait_object_id_offset, &wait_object->id);
-    ret = ret && (err == 0);
+    /* Read the thread id and the next task address at once */
+    PROFILER_SITE(PROFILER_SITE_TCB);
+    err = gdb_api->pfReadMem(thread_address + nano_os_plugin.task_link_span_start, (char*)data, nano_os_plugin.task_link_span_size);
+    ret = ret && (err != 0);
+    if (ret)
+    {
+        /* Decode the thread id */
+        thread->id = (U16)gdb_api->pfLoad16TE(TCB_LINK_FIELD(data, task_id_offset));
+
+        /* Decode the next task address */
+        thread->next_thread = gdb_api->pfLoad32TE(TCB_LINK_FIELD(data, next_task_offset));
+    }
+
+    /* Delay details load */
+    thread->details_loaded = false;
+
+    return ret;
+}
 
-    /* Read the name */
-    if (nano_os_plugin.offsets.wait_object_name_offset == NANO_OS_PLUGIN_INVALID_OFFSET8)
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 1) */
+
+/** \brief Load the details of a thread if they have not been loaded yet during the halt */
+static bool loadThreadDetails(nano_os_thread_t* const thread)
+{
+    bool ret = true;
+
+    TRACE_BEGIN(__func__);
+
+    if (!thread->details_loaded)
     {
-        strcpy(wait_object->name, "");
+        ret = fillNanoOsThreadInfos(thread->tcb_address, thread);
+        if (ret && (thread->wait_object != NULL) && !thread->wait_object->loaded)
+        {
+            /* First thread loaded which is waiting on this object, read it */
+            nano_os_wait_object_t* const wait_object = thread->wait_object;
+            int err;
+            PROFILER_SITE(PROFILER_SITE_WAIT_OBJECT);
+            err = gdb_api->pfReadMem(wait_object->address + nano_os_plugin.wait_object_span_start, (char*)wait_object->data, nano_os_plugin.wait_object_span_size);
+            wait_object->loaded = (err != 0);
+            ret = fillNanoOsWaitObjectInfos(wait_object);
+        }
+        thread->details_loaded = ret;
     }
-    else
+
+    TRACE_END(__func__);
+    return ret;
+}
+
+/** \brief Get the slot of a wait object in the lookup table, or the free slot where to register it */
+static U32 findWaitObjectSlot(const U32 wait_object_address)
+{
+    const U32 mask = (2u * nano_os_plugin.wait_object_capacity) - 1u;
+    U32 slot = ((wait_object_address * 2654435761u) >> 16u) & mask;
+
+    /* Look for the wait object in the objects already registered during this update */
+    while ((nano_os_plugin.wait_object_table[slot] != 0u) &&
+           (nano_os_plugin.wait_objects[nano_os_plugin.wait_object_table[slot] - 1u].address != wait_object_address))
     {
-        ret = readString(wait_object_address + nano_os_plugin.offsets.wait_object_name_offset, wait_object->name, sizeof(wait_object->name));
+        slot = (slot + 1u) & mask;
     }
 
-    /* Read the type */
-    err = gdb_api->pfReadU8(wait_object_address + nano_os_plugin.offsets.wait_object_type_offset, &wait_object->type);
-    ret = ret && (err == 0);
+    return slot;
+}
+
+/** \brief Get a wait object, registering it only once per update */
+static nano_os_wait_object_t* getWaitObject(const U32 wait_object_address)
+{
+    nano_os_wait_object_t* wait_object = NULL;
+    const U32 slot = findWaitObjectSlot(wait_object_address);
 
+    if (nano_os_plugin.wait_object_table[slot] != 0u)
+    {
+        wait_object = &nano_os_plugin.wait_objects[nano_os_plugin.wait_object_table[slot] - 1u];
+    }
+    else if (nano_os_plugin.wait_object_count < nano_os_plugin.wait_object_capacity)
+    {
+        /* First thread waiting on this object, register it to be read after the thread list walk */
+        wait_object = &nano_os_plugin.wait_objects[nano_os_plugin.wait_object_count];
+        memset(wait_object, 0, sizeof(nano_os_wait_object_t));
+        wait_object->address = wait_object_address;
+        nano_os_plugin.wait_object_count++;
+        nano_os_plugin.wait_object_table[slot] = nano_os_plugin.wait_object_count;
+    }
+    if (wait_object != NULL)
+    {
+        wait_object->waiter_count++;
+    }
+
+    return wait_object;
+}
+
+/** \brief Macro to get a pointer to a field inside a wait object read in one transfer */
+#define WAIT_OBJECT_FIELD(data, field_offset)   (&(data)[nano_os_plugin.offsets.field_offset - nano_os_plugin.wait_object_span_start])
+
+#if (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0)
+
+/** \brief Read the wait objects and saved contexts referenced during the thread list walk */
+static bool fillNanoOsDeferredInfos(void)
+{
+    U32 i;
+    U32 transfer_count;
+    bool ret = true;
+
+    TRACE_BEGIN(__func__);
+    PROFILER_SITE(PROFILER_SITE_READ_PLAN);
+
+    /* Read all the needed fields of all the wait objects in merged transfers */
+    READPLAN_reset();
+    for (i = 0u; i < nano_os_plugin.wait_object_count; i++)
+    {
+        nano_os_wait_object_t* const wait_object = &nano_os_plugin.wait_objects[i];
+        const U32 address = wait_object->address + nano_os_plugin.wait_object_span_start;
+        if (!READPLAN_add(address, nano_os_plugin.wait_object_span_size, wait_object->data, &wait_object->loaded))
+        {
+            wait_object->loaded = (gdb_api->pfReadMem(address, (char*)wait_object->data, nano_os_plugin.wait_object_span_size) != 0);
+        }
+    }
+
+#if (NANO_OS_PLUGIN_STACK_PREFETCH_ENABLED == 1)
+    /* Read the saved contexts of the non running threads in the same transfers */
+    for (i = 0u; (i < nano_os_plugin.thread_count) && nano_os_plugin.stack_prefetch; i++)
+    {
+        nano_os_thread_t* const thread = &nano_os_plugin.threads[i];
+        if ((thread != nano_os_plugin.current_thread) && !thread->stack_loaded)
+        {
+            /* Contexts which can't be planned will be loaded on the first register access */
+            const U32 stack_address = prepareThreadStack(thread);
+            if (allocateThreadStack(thread))
+            {
+                (void)READPLAN_add(stack_address, thread->stack_frame_size, thread->stack, &thread->stack_loaded);
+            }
+        }
+    }
+#endif /* (NANO_OS_PLUGIN_STACK_PREFETCH_ENABLED == 1) */
+
+    transfer_count = READPLAN_execute(gdb_api, NANO_OS_PLUGIN_READ_PLAN_MAX_GAP);
+    STATS_ADD(STATS_COUNTER_DEFERRED_TRANSFERS, transfer_count);
+
+    /* Decode the wait objects */
+    for (i = 0u; (i < nano_os_plugin.wait_object_count) && ret; i++)
+    {
+        ret = fillNanoOsWaitObjectInfos(&nano_os_plugin.wait_objects[i]);
+    }
+
+    TRACE_END(__func__);
     return ret;
 }
 
+#endif /* (NANO_OS_PLUGIN_LAZY_THREAD_DETAILS_ENABLED == 0) */
+
+/** \brief Fill a wait object information */
+static bool fillNanoOsWaitObjectInfos(nano_os_wait_object_t* const wait_object)
+{
+    bool ret = wait_object->loaded;
+    const U8* const data = wait_object->data;
+    if (ret)
+    {
+        /* Decode the id */
+        wait_object->id = (U16)gdb_api->pfLoad16TE(WAIT_OBJECT_FIELD(data, wait_object_id_offset));
+
+        /* Read the name */
+        if (nano_os_plugin.offsets.wait_object_name_offset == NANO_OS_PLUGIN_INVALID_OFFSET8)
+        {
+            wait_object->name = STRINGPOOL_EMPTY;
+        }
+        else
+        {
+            ret = readString(gdb_api->pfLoad32TE(WAIT_OBJECT_FIELD(data, wait_object_name_offset)), false, &wait_object->name);
+        }
+
+        /* Decode the type */
+        wait_object->type = *WAIT_OBJECT_FIELD(data, wait_object_type_offset);
+    }
+
+    return ret;
+}
+
+
+/** \brief Get the address of the saved context of a thread and set its top of stack in the local copy */
+static U32 prepareThreadStack(nano_os_thread_t* const thread)
+{
+    U32 stack_address = thread->top_of_stack_address;
+    if (nano_os_plugin.cpu->stack_growth_dir == ASCENDING_STACK)
+    {
+        stack_address -= thread->stack_frame_size;
+        thread->top_of_stack_offset = thread->stack_frame_size;
+    }
+    else
+    {
+        thread->top_of_stack_offset = 0u;
+    }
+
+    return stack_address;
+}
 
 /** \brief Dump the stack of a thread */
 static bool dumpThreadStack(nano_os_thread_t* const thread)
 {
     bool ret = true;
 
+    TRACE_BEGIN(__func__);
+    PROFILER_SITE(PROFILER_SITE_STACK_FRAME);
+
     /* Check if the stack has already been loaded */
     if (!thread->stack_loaded)
     {
         /* Read stack memory */
-        int err;
-        U32 stack_address = thread->top_of_stack_address;
-        if (nano_os_plugin.cpu->stack_growth_dir == ASCENDING_STACK)
-        {
-            stack_address -= nano_os_plugin.cpu_stack_frame_size;
-        }
-
-        /* Stack has been loaded */
-        err = gdb_api->pfReadMem(stack_address, thread->stack, nano_os_plugin.cpu_stack_frame_size);
-        ret = ret && (err != 0);
+        const U32 stack_address = prepareThreadStack(thread);
+        ret = allocateThreadStack(thread);
         if (ret)
         {
-            if (nano_os_plugin.cpu->stack_growth_dir == ASCENDING_STACK)
-            {
-                thread->top_of_stack = thread->stack + nano_os_plugin.cpu_stack_frame_size;
-            }
-            else
-            {
-                thread->top_of_stack = thread->stack;
-            }
-            thread->stack_loaded = true;
+            /* Stack has been loaded */
+            const int err = gdb_api->pfReadMem(stack_address, (char*)thread->stack, thread->stack_frame_size);
+            ret = (err != 0);
         }
+        thread->stack_loaded = ret;
     }
 
+    TRACE_END(__func__);
     return ret;
 }
+
+/** \brief Allocate the local copy of the saved context of a thread in the transient memory of the current update */
+static bool allocateThreadStack(nano_os_thread_t* const thread)
+{
+    thread->stack = (U8*)REGION_alloc(&nano_os_plugin.region, gdb_api, thread->stack_frame_size);
+    return (thread->stack != NULL);
+}
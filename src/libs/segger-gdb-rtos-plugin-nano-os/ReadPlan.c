@@ -0,0 +1,167 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReadPlan.h"
+
+#include <stdlib.h>
+
+
+/** \brief Read request */
+typedef struct _readplan_request_t
+{
+    /** \brief Target address */
+    U32 address;
+    /** \brief Size in bytes */
+    U32 size;
+    /** \brief Destination buffer */
+    U8* data;
+    /** \brief Indicate if the read succeeded */
+    bool* loaded;
+} readplan_request_t;
+
+
+/** \brief Requests of the current plan */
+static readplan_request_t readplan_requests[READPLAN_MAX_REQUESTS];
+
+/** \brief Number of requests in the current plan */
+static U32 readplan_request_count = 0u;
+
+/** \brief Buffer for the merged target reads */
+static U8 readplan_transfer_buffer[READPLAN_MAX_TRANSFER_SIZE];
+
+
+
+/** \brief Compare the address of 2 requests */
+static int READPLAN_compareRequests(const void* a, const void* b)
+{
+    const readplan_request_t* const request_a = (const readplan_request_t*)a;
+    const readplan_request_t* const request_b = (const readplan_request_t*)b;
+    int ret = 0;
+    if (request_a->address < request_b->address)
+    {
+        ret = -1;
+    }
+    else if (request_a->address > request_b->address)
+    {
+        ret = 1;
+    }
+    return ret;
+}
+
+/** \brief Issue a merged target read and scatter the result to the requests it covers */
+static U32 READPLAN_transfer(const GDB_API* const gdb_api, const U32 first_request, const U32 last_request, const U32 start, const U32 end)
+{
+    U32 i;
+    U32 transfer_count = 1u;
+
+    int err = gdb_api->pfReadMem(start, (char*)readplan_transfer_buffer, end - start);
+    for (i = first_request; i <= last_request; i++)
+    {
+        readplan_request_t* const request = &readplan_requests[i];
+        if (err != 0)
+        {
+            memcpy(request->data, &readplan_transfer_buffer[request->address - start], request->size);
+            (*request->loaded) = true;
+        }
+        else
+        {
+            /* The merged area is not fully readable, fall back to the request itself */
+            (*request->loaded) = (gdb_api->pfReadMem(request->address, (char*)request->data, request->size) != 0);
+            transfer_count++;
+        }
+    }
+
+    return transfer_count;
+}
+
+
+/** \brief Start a new read plan */
+void READPLAN_reset(void)
+{
+    readplan_request_count = 0u;
+}
+
+/** \brief Add a read request to the plan, the result will be copied to data and loaded set to true if the read succeeded
+           (returns false if the plan is full, the request must then be read directly) */
+bool READPLAN_add(const U32 address, const U32 size, void* const data, bool* const loaded)
+{
+    bool ret = false;
+    if ((readplan_request_count < READPLAN_MAX_REQUESTS) && (size != 0u) && (size <= READPLAN_MAX_TRANSFER_SIZE))
+    {
+        readplan_request_t* const request = &readplan_requests[readplan_request_count];
+        request->address = address;
+        request->size = size;
+        request->data = (U8*)data;
+        request->loaded = loaded;
+        (*loaded) = false;
+        readplan_request_count++;
+        ret = true;
+    }
+    return ret;
+}
+
+/** \brief Execute the plan by merging the requests which are contiguous or separated by at most max_gap bytes,
+           returns the number of target reads issued */
+U32 READPLAN_execute(const GDB_API* const gdb_api, const U32 max_gap)
+{
+    U32 i;
+    U32 transfer_count = 0u;
+
+    if (readplan_request_count != 0u)
+    {
+        U32 first_request = 0u;
+        U32 start;
+        U32 end;
+
+        /* Sort the requests by address */
+        qsort(readplan_requests, readplan_request_count, sizeof(readplan_request_t), READPLAN_compareRequests);
+
+        /* Merge the requests */
+        start = readplan_requests[0u].address;
+        end = start + readplan_requests[0u].size;
+        for (i = 1u; i < readplan_request_count; i++)
+        {
+            const readplan_request_t* const request = &readplan_requests[i];
+            U32 request_end = request->address + request->size;
+            if (request_end < end)
+            {
+                request_end = end;
+            }
+            if ((request->address <= (end + max_gap)) && ((request_end - start) <= READPLAN_MAX_TRANSFER_SIZE))
+            {
+                /* Extend the current transfer */
+                end = request_end;
+            }
+            else
+            {
+                /* Issue the current transfer and start a new one */
+                transfer_count += READPLAN_transfer(gdb_api, first_request, i - 1u, start, end);
+                first_request = i;
+                start = request->address;
+                end = request->address + request->size;
+            }
+        }
+        transfer_count += READPLAN_transfer(gdb_api, first_request, readplan_request_count - 1u, start, end);
+
+        /* Plan is done */
+        readplan_request_count = 0u;
+    }
+
+    return transfer_count;
+}
@@ -0,0 +1,48 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef READPLAN_H
+#define READPLAN_H
+
+#include "RTOSPlugin.h"
+
+#include <stdbool.h>
+
+
+/** \brief Maximum number of read requests in a plan */
+#define READPLAN_MAX_REQUESTS       2048u
+
+/** \brief Maximum size in bytes of a merged target read */
+#define READPLAN_MAX_TRANSFER_SIZE  4096u
+
+
+
+/** \brief Start a new read plan */
+void READPLAN_reset(void);
+
+/** \brief Add a read request to the plan, the result will be copied to data and loaded set to true if the read succeeded
+           (returns false if the plan is full, the request must then be read directly) */
+bool READPLAN_add(const U32 address, const U32 size, void* const data, bool* const loaded);
+
+/** \brief Execute the plan by merging the requests which are contiguous or separated by at most max_gap bytes,
+           returns the number of target reads issued */
+U32 READPLAN_execute(const GDB_API* const gdb_api, const U32 max_gap);
+
+
+#endif /* READPLAN_H */
@@ -0,0 +1,231 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Recorder.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+
+#if (RECORDER_ENABLED == 1)
+
+/** \brief GDB server API used to access the target */
+static const GDB_API* recorder_target_api = NULL;
+
+/** \brief Recording API */
+static GDB_API recorder_api;
+
+/** \brief RTOS symbols of the plugin */
+static const RTOS_SYMBOLS* recorder_symbols = NULL;
+
+/** \brief Session file */
+static FILE* recorder_file = NULL;
+
+
+
+/** \brief Write a 32 bits little endian value to a record */
+static U8* RECORDER_put32(U8* const record, const U32 value)
+{
+    record[0u] = (U8)(value);
+    record[1u] = (U8)(value >> 8u);
+    record[2u] = (U8)(value >> 16u);
+    record[3u] = (U8)(value >> 24u);
+    return &record[4u];
+}
+
+/** \brief Write a record to the session file */
+static void RECORDER_write(const U8* const record, const U32 size)
+{
+    (void)fwrite(record, 1u, size, recorder_file);
+}
+
+/** \brief Record a target read */
+static void RECORDER_writeRead(const U32 address, const void* const data, const U32 size, const bool success)
+{
+    U8 record[10u];
+    U8* field = record;
+
+    (*field) = RECORDER_TAG_READ;
+    field++;
+    (*field) = (success ? 1u : 0u);
+    field++;
+    field = RECORDER_put32(field, address);
+    field = RECORDER_put32(field, size);
+    RECORDER_write(record, (U32)(field - record));
+    if (success)
+    {
+        RECORDER_write((const U8*)data, size);
+    }
+}
+
+/** \brief Record the addresses of the RTOS symbols */
+static void RECORDER_writeSymbols(void)
+{
+    U8 record[2u + 4u * RECORDER_MAX_SYMBOLS];
+    U8* field = &record[2u];
+    U8 count = 0u;
+
+    while ((recorder_symbols[count].name != NULL) && (count < RECORDER_MAX_SYMBOLS))
+    {
+        field = RECORDER_put32(field, recorder_symbols[count].address);
+        count++;
+    }
+    record[0u] = RECORDER_TAG_SYMBOLS;
+    record[1u] = count;
+    RECORDER_write(record, (U32)(field - record));
+}
+
+/** \brief Close the session file at the end of the process */
+static void RECORDER_close(void)
+{
+    if (recorder_file != NULL)
+    {
+        fclose(recorder_file);
+        recorder_file = NULL;
+    }
+}
+
+/** \brief Read a memory area */
+static int RECORDER_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    const int ret = recorder_target_api->pfReadMem(Addr, pData, NumBytes);
+    RECORDER_writeRead(Addr, pData, NumBytes, (ret != 0));
+    return ret;
+}
+
+/** \brief Read a byte */
+static char RECORDER_ReadU8(U32 Addr, U8* pData)
+{
+    const char ret = recorder_target_api->pfReadU8(Addr, pData);
+    RECORDER_writeRead(Addr, pData, 1u, (ret == 0));
+    return ret;
+}
+
+/** \brief Read a half word */
+static char RECORDER_ReadU16(U32 Addr, U16* pData)
+{
+    U8 data[2u];
+    const char ret = recorder_target_api->pfReadU16(Addr, pData);
+    data[0u] = (U8)(*pData);
+    data[1u] = (U8)((*pData) >> 8u);
+    RECORDER_writeRead(Addr, data, 2u, (ret == 0));
+    return ret;
+}
+
+/** \brief Read a word */
+static char RECORDER_ReadU32(U32 Addr, U32* pData)
+{
+    U8 data[4u];
+    const char ret = recorder_target_api->pfReadU32(Addr, pData);
+    (void)RECORDER_put32(data, (*pData));
+    RECORDER_writeRead(Addr, data, 4u, (ret == 0));
+    return ret;
+}
+
+
+/** \brief Open the session file if configured and get the API recording the target reads
+           (the given API is returned as is if no session file is configured) */
+const GDB_API* RECORDER_init(const GDB_API* const target_api, const RTOS_SYMBOLS* const symbols)
+{
+    const GDB_API* ret = target_api;
+    const char* const path = getenv(RECORDER_FILE_ENV_VAR);
+
+    /* The session file is kept open across the sessions so that the whole debug session is recorded */
+    if ((recorder_file == NULL) && (path != NULL) && (path[0u] != 0))
+    {
+        recorder_file = fopen(path, "wb");
+        if (recorder_file != NULL)
+        {
+            U8 header[8u];
+            (void)RECORDER_put32(RECORDER_put32(header, RECORDER_FILE_MAGIC), RECORDER_FILE_VERSION);
+            RECORDER_write(header, sizeof(header));
+            (void)atexit(RECORDER_close);
+            target_api->pfLogOutf("Nano-OS plugin: recording session to %s\n", path);
+        }
+        else
+        {
+            target_api->pfWarnOutf("Nano-OS plugin: unable to open session file %s\n", path);
+        }
+    }
+    if (recorder_file != NULL)
+    {
+        /* Build the recording API, half words and words are recorded in little endian like the Cortex-M targets */
+        recorder_target_api = target_api;
+        recorder_symbols = symbols;
+        recorder_api = (*target_api);
+        recorder_api.pfReadMem = RECORDER_ReadMem;
+        recorder_api.pfReadU8 = RECORDER_ReadU8;
+        recorder_api.pfReadU16 = RECORDER_ReadU16;
+        recorder_api.pfReadU32 = RECORDER_ReadU32;
+        ret = &recorder_api;
+    }
+
+    return ret;
+}
+
+/** \brief Record a call to an exported entry point, the symbol addresses are recorded before each update */
+void RECORDER_call(const recorder_call_t call, const U32 arg0, const U32 arg1)
+{
+    if (recorder_file != NULL)
+    {
+        U8 record[10u];
+        if (call == RECORDER_CALL_UPDATE_THREADS)
+        {
+            RECORDER_writeSymbols();
+        }
+        record[0u] = RECORDER_TAG_CALL;
+        record[1u] = (U8)call;
+        (void)RECORDER_put32(RECORDER_put32(&record[2u], arg0), arg1);
+        RECORDER_write(record, sizeof(record));
+    }
+}
+
+/** \brief Write the recorded data to the session file */
+void RECORDER_flush(void)
+{
+    if (recorder_file != NULL)
+    {
+        (void)fflush(recorder_file);
+    }
+}
+
+#else
+
+/** \brief The recorder is not built, the given API is returned as is */
+const GDB_API* RECORDER_init(const GDB_API* const target_api, const RTOS_SYMBOLS* const symbols)
+{
+    (void)symbols;
+    return target_api;
+}
+
+/** \brief The recorder is not built, nothing is recorded */
+void RECORDER_call(const recorder_call_t call, const U32 arg0, const U32 arg1)
+{
+    (void)call;
+    (void)arg0;
+    (void)arg1;
+}
+
+/** \brief The recorder is not built, nothing is written */
+void RECORDER_flush(void)
+{
+}
+
+#endif /* (RECORDER_ENABLED == 1) */
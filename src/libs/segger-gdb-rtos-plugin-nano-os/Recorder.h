@@ -0,0 +1,115 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Enable the build of the debug session recorder */
+#define RECORDER_ENABLED            1
+
+/** \brief Name of the environment variable containing the path to the session file
+           (the file is flushed after each update and closed at the end of the process) */
+#define RECORDER_FILE_ENV_VAR       "NANO_OS_PLUGIN_RECORD_FILE"
+
+
+/** \brief Session file magic number ("NOSR") */
+#define RECORDER_FILE_MAGIC         0x52534F4Eu
+
+/** \brief Session file format version */
+#define RECORDER_FILE_VERSION       1u
+
+/** \brief Maximum number of symbols in a symbols record */
+#define RECORDER_MAX_SYMBOLS        16u
+
+
+/** \brief Session file records, all the fields are little endian :
+            - header : magic (U32), version (U32)
+            - call : tag (U8), call (U8), arg0 (U32), arg1 (U32)
+            - symbols : tag (U8), count (U8), addresses (count x U32)
+            - read : tag (U8), success (U8), address (U32), size (U32), data (size x U8, only if success) */
+typedef enum _recorder_tag_t
+{
+    /** \brief Call to an exported entry point */
+    RECORDER_TAG_CALL = 1u,
+    /** \brief Addresses of the RTOS symbols, written before each update */
+    RECORDER_TAG_SYMBOLS = 2u,
+    /** \brief Target read through the GDB server */
+    RECORDER_TAG_READ = 3u
+} recorder_tag_t;
+
+/** \brief Recorded entry points */
+typedef enum _recorder_call_t
+{
+    /** \brief RTOS_Init(core) */
+    RECORDER_CALL_INIT = 0u,
+    /** \brief RTOS_GetNumThreads() */
+    RECORDER_CALL_GET_NUM_THREADS,
+    /** \brief RTOS_GetCurrentThreadId() */
+    RECORDER_CALL_GET_CURRENT_THREAD_ID,
+    /** \brief RTOS_GetThreadId(n) */
+    RECORDER_CALL_GET_THREAD_ID,
+    /** \brief RTOS_GetThreadDisplay(threadid) */
+    RECORDER_CALL_GET_THREAD_DISPLAY,
+    /** \brief RTOS_GetThreadReg(RegIndex, threadid) */
+    RECORDER_CALL_GET_THREAD_REG,
+    /** \brief RTOS_GetThreadRegList(threadid) */
+    RECORDER_CALL_GET_THREAD_REG_LIST,
+    /** \brief RTOS_SetThreadReg(RegIndex, threadid) */
+    RECORDER_CALL_SET_THREAD_REG,
+    /** \brief RTOS_SetThreadRegList(threadid) */
+    RECORDER_CALL_SET_THREAD_REG_LIST,
+    /** \brief RTOS_UpdateThreads() */
+    RECORDER_CALL_UPDATE_THREADS,
+
+    /** \brief Number of entry points */
+    RECORDER_CALL_MAX
+} recorder_call_t;
+
+
+#if (RECORDER_ENABLED == 1)
+
+/** \brief Macro to record a call to an exported entry point */
+#define RECORDER_CALL(call, arg0, arg1)     RECORDER_call(call, (U32)(arg0), (U32)(arg1))
+
+/** \brief Macro to write the recorded data to the session file */
+#define RECORDER_FLUSH()                    RECORDER_flush()
+
+#else
+
+#define RECORDER_CALL(call, arg0, arg1)
+#define RECORDER_FLUSH()
+
+#endif /* (RECORDER_ENABLED == 1) */
+
+
+/** \brief Open the session file if configured and get the API recording the target reads
+           (the given API is returned as is if no session file is configured) */
+const GDB_API* RECORDER_init(const GDB_API* const target_api, const RTOS_SYMBOLS* const symbols);
+
+/** \brief Record a call to an exported entry point, the symbol addresses are recorded before each update */
+void RECORDER_call(const recorder_call_t call, const U32 arg0, const U32 arg1);
+
+/** \brief Write the recorded data to the session file */
+void RECORDER_flush(void);
+
+
+#endif /* RECORDER_H */
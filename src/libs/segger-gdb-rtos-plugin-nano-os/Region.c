@@ -0,0 +1,110 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Region.h"
+
+
+/** \brief Size in bytes of the header of a chunk, the allocations start after it */
+#define REGION_CHUNK_HEADER_SIZE    ((U32)((sizeof(region_chunk_t) + REGION_ALIGNMENT - 1u) & ~(REGION_ALIGNMENT - 1u)))
+
+
+
+/** \brief Release all the allocations of a region at once, its chunks are kept for the next allocations */
+void REGION_reset(region_t* const region)
+{
+    region->current = region->first;
+    region->offset = 0u;
+    region->used = 0u;
+}
+
+/** \brief Allocate memory in a region, it stays valid until the next reset (returns NULL if no chunk can be allocated) */
+void* REGION_alloc(region_t* const region, const GDB_API* const gdb_api, const U32 size)
+{
+    void* ret = NULL;
+    const U32 aligned_size = (size + REGION_ALIGNMENT - 1u) & ~(REGION_ALIGNMENT - 1u);
+
+    /* Move to the chunks kept from the previous resets until one has enough room left */
+    while ((region->current != NULL) && ((region->offset + aligned_size) > region->current->size) && (region->current->next != NULL))
+    {
+        region->current = region->current->next;
+        region->offset = 0u;
+    }
+
+    /* Add a chunk at the end of the region */
+    if ((region->current == NULL) || ((region->offset + aligned_size) > region->current->size))
+    {
+        const U32 chunk_size = ((aligned_size > REGION_CHUNK_SIZE) ? aligned_size : REGION_CHUNK_SIZE);
+        region_chunk_t* const chunk = (region_chunk_t*)gdb_api->pfAlloc(REGION_CHUNK_HEADER_SIZE + chunk_size);
+        if (chunk != NULL)
+        {
+            chunk->next = NULL;
+            chunk->size = chunk_size;
+            if (region->current == NULL)
+            {
+                region->first = chunk;
+            }
+            else
+            {
+                region->current->next = chunk;
+            }
+            region->current = chunk;
+            region->offset = 0u;
+            region->size += chunk_size;
+        }
+    }
+
+    /* Bump the offset in the current chunk */
+    if ((region->current != NULL) && ((region->offset + aligned_size) <= region->current->size))
+    {
+        ret = ((U8*)region->current) + REGION_CHUNK_HEADER_SIZE + region->offset;
+        region->offset += aligned_size;
+        region->used += aligned_size;
+        if (region->used > region->peak)
+        {
+            region->peak = region->used;
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Give back all the chunks of a region to the GDB server */
+void REGION_release(region_t* const region, const GDB_API* const gdb_api)
+{
+    region_chunk_t* chunk = region->first;
+    while (chunk != NULL)
+    {
+        region_chunk_t* const next = chunk->next;
+        gdb_api->pfFree(chunk);
+        chunk = next;
+    }
+    memset(region, 0, sizeof(region_t));
+}
+
+/** \brief Get the highest number of bytes handed out by a region between 2 resets */
+U32 REGION_getPeakUsage(const region_t* const region)
+{
+    return region->peak;
+}
+
+/** \brief Get the number of bytes of all the chunks of a region */
+U32 REGION_getSize(const region_t* const region)
+{
+    return region->size;
+}
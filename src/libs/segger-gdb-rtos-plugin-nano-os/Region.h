@@ -0,0 +1,77 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REGION_H
+#define REGION_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Size in bytes of the chunks requested to the GDB server (larger allocations get a chunk of their own size) */
+#define REGION_CHUNK_SIZE           65536u
+
+/** \brief Alignment in bytes of the allocations */
+#define REGION_ALIGNMENT            8u
+
+
+/** \brief Chunk of memory of a region */
+typedef struct _region_chunk_t
+{
+    /** \brief Next chunk */
+    struct _region_chunk_t* next;
+    /** \brief Size in bytes available for the allocations */
+    U32 size;
+} region_chunk_t;
+
+/** \brief Region of memory whose allocations are all released at once */
+typedef struct _region_t
+{
+    /** \brief First chunk, the chunks are kept from one reset to the other */
+    region_chunk_t* first;
+    /** \brief Chunk in which the allocations are done */
+    region_chunk_t* current;
+    /** \brief Number of bytes used in the current chunk */
+    U32 offset;
+    /** \brief Number of bytes handed out since the last reset */
+    U32 used;
+    /** \brief Highest number of bytes handed out between 2 resets */
+    U32 peak;
+    /** \brief Number of bytes of all the chunks */
+    U32 size;
+} region_t;
+
+
+
+/** \brief Release all the allocations of a region at once, its chunks are kept for the next allocations */
+void REGION_reset(region_t* const region);
+
+/** \brief Allocate memory in a region, it stays valid until the next reset (returns NULL if no chunk can be allocated) */
+void* REGION_alloc(region_t* const region, const GDB_API* const gdb_api, const U32 size);
+
+/** \brief Give back all the chunks of a region to the GDB server */
+void REGION_release(region_t* const region, const GDB_API* const gdb_api);
+
+/** \brief Get the highest number of bytes handed out by a region between 2 resets */
+U32 REGION_getPeakUsage(const region_t* const region);
+
+/** \brief Get the number of bytes of all the chunks of a region */
+U32 REGION_getSize(const region_t* const region);
+
+
+#endif /* REGION_H */
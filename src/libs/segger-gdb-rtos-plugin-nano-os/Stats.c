@@ -0,0 +1,327 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Stats.h"
+#include "Timer.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+
+/** \brief Counters of an entry point */
+typedef struct _stats_counters_t
+{
+    /** \brief Number of calls */
+    U32 calls;
+    /** \brief Number of read requests sent to the GDB server */
+    U32 read_calls;
+    /** \brief Number of bytes read through the GDB server */
+    U32 read_bytes;
+    /** \brief Number of write requests sent to the GDB server */
+    U32 write_calls;
+    /** \brief Total time spent in us */
+    U64 total_time;
+    /** \brief Maximum duration of a call in us */
+    U32 max_time;
+    /** \brief Latency histogram */
+    U32 histogram[STATS_HISTOGRAM_SIZE];
+} stats_counters_t;
+
+
+/** \brief Names of the entry points */
+static const char* const stats_entry_names[STATS_ENTRY_MAX] = {
+                                                                "RTOS_GetNumThreads",
+                                                                "RTOS_GetCurrentThreadId",
+                                                                "RTOS_GetThreadId",
+                                                                "RTOS_GetThreadDisplay",
+                                                                "RTOS_GetThreadReg",
+                                                                "RTOS_GetThreadRegList",
+                                                                "RTOS_SetThreadReg",
+                                                                "RTOS_SetThreadRegList",
+                                                                "RTOS_UpdateThreads",
+                                                                "Other"
+                                                              };
+
+/** \brief Names of the counters */
+static const char* const stats_counter_names[STATS_COUNTER_MAX] = {
+                                                                    "tcb_prefetch_transfers",
+                                                                    "deferred_transfers",
+                                                                    "transient_memory_peak",
+                                                                    "transient_memory_size",
+                                                                    "name_pool_size",
+                                                                    "string_bytes",
+                                                                    "string_bytes_saved"
+                                                                  };
+
+/** \brief GDB server API used to access the target */
+static const GDB_API* stats_target_api = NULL;
+
+/** \brief Counting API */
+static GDB_API stats_api;
+
+/** \brief Indicate if the counters are enabled */
+static bool stats_enabled = false;
+
+/** \brief Number of halts between 2 summaries */
+static U32 stats_period = 0u;
+
+/** \brief Number of halts since the start of the session */
+static U32 stats_halt_count = 0u;
+
+/** \brief Entry point currently measured */
+static stats_entry_t stats_current_entry = STATS_ENTRY_OTHER;
+
+/** \brief Start time of the entry point currently measured in us */
+static U64 stats_start_time = 0u;
+
+/** \brief Counters of all the entry points */
+static stats_counters_t stats_counters[STATS_ENTRY_MAX];
+
+/** \brief Counters of the plugin internals */
+static U32 stats_values[STATS_COUNTER_MAX];
+
+/** \brief Number of bytes read through the GDB server since the start of the session */
+static U32 stats_read_bytes = 0u;
+
+
+
+/** \brief Count a read request */
+static void STATS_countRead(const U32 size)
+{
+    stats_counters[stats_current_entry].read_calls++;
+    stats_counters[stats_current_entry].read_bytes += size;
+    stats_read_bytes += size;
+}
+
+/** \brief Read a memory area */
+static int STATS_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    STATS_countRead(NumBytes);
+    return stats_target_api->pfReadMem(Addr, pData, NumBytes);
+}
+
+/** \brief Read a byte */
+static char STATS_ReadU8(U32 Addr, U8* pData)
+{
+    STATS_countRead(1u);
+    return stats_target_api->pfReadU8(Addr, pData);
+}
+
+/** \brief Read a half word */
+static char STATS_ReadU16(U32 Addr, U16* pData)
+{
+    STATS_countRead(2u);
+    return stats_target_api->pfReadU16(Addr, pData);
+}
+
+/** \brief Read a word */
+static char STATS_ReadU32(U32 Addr, U32* pData)
+{
+    STATS_countRead(4u);
+    return stats_target_api->pfReadU32(Addr, pData);
+}
+
+/** \brief Write a memory area */
+static int STATS_WriteMem(U32 Addr, const char* pData, unsigned NumBytes)
+{
+    stats_counters[stats_current_entry].write_calls++;
+    return stats_target_api->pfWriteMem(Addr, pData, NumBytes);
+}
+
+/** \brief Write a byte */
+static void STATS_WriteU8(U32 Addr, U8 Data)
+{
+    stats_counters[stats_current_entry].write_calls++;
+    stats_target_api->pfWriteU8(Addr, Data);
+}
+
+/** \brief Write a half word */
+static void STATS_WriteU16(U32 Addr, U16 Data)
+{
+    stats_counters[stats_current_entry].write_calls++;
+    stats_target_api->pfWriteU16(Addr, Data);
+}
+
+/** \brief Write a word */
+static void STATS_WriteU32(U32 Addr, U32 Data)
+{
+    stats_counters[stats_current_entry].write_calls++;
+    stats_target_api->pfWriteU32(Addr, Data);
+}
+
+
+/** \brief Start a new session, report the counters of the previous one and get the counting API
+           (the given API is returned as is if the counters are not enabled) */
+const GDB_API* STATS_init(const GDB_API* const target_api)
+{
+    const GDB_API* ret = target_api;
+    const char* const period = getenv(STATS_PERIOD_ENV_VAR);
+
+    /* End of the previous session */
+    STATS_endSession();
+    stats_current_entry = STATS_ENTRY_OTHER;
+    stats_enabled = false;
+
+    /* Check if the counters have been enabled */
+    if ((STATS_ENABLED == 1) && (period != NULL) && (period[0u] != 0))
+    {
+        /* Build the counting API */
+        stats_target_api = target_api;
+        stats_api = (*target_api);
+        stats_api.pfReadMem = STATS_ReadMem;
+        stats_api.pfReadU8 = STATS_ReadU8;
+        stats_api.pfReadU16 = STATS_ReadU16;
+        stats_api.pfReadU32 = STATS_ReadU32;
+        stats_api.pfWriteMem = STATS_WriteMem;
+        stats_api.pfWriteU8 = STATS_WriteU8;
+        stats_api.pfWriteU16 = STATS_WriteU16;
+        stats_api.pfWriteU32 = STATS_WriteU32;
+        stats_period = (U32)strtoul(period, NULL, 0);
+        stats_enabled = true;
+        ret = &stats_api;
+    }
+
+    return ret;
+}
+
+/** \brief Start measuring an entry point */
+void STATS_enter(const stats_entry_t entry)
+{
+    if (stats_enabled)
+    {
+        stats_current_entry = entry;
+        stats_start_time = TIMER_getTime();
+    }
+}
+
+/** \brief Stop measuring an entry point, a summary is reported every configured number of halts */
+void STATS_leave(const stats_entry_t entry)
+{
+    if (stats_enabled)
+    {
+        U32 bucket = 0u;
+        stats_counters_t* const counters = &stats_counters[entry];
+        const U32 duration = (U32)(TIMER_getTime() - stats_start_time);
+
+        /* Update the counters */
+        counters->calls++;
+        counters->total_time += duration;
+        if (duration > counters->max_time)
+        {
+            counters->max_time = duration;
+        }
+        while (((duration >> bucket) != 0u) && (bucket < (STATS_HISTOGRAM_SIZE - 1u)))
+        {
+            bucket++;
+        }
+        counters->histogram[bucket]++;
+        stats_current_entry = STATS_ENTRY_OTHER;
+
+        /* Periodic summary */
+        if (entry == STATS_ENTRY_UPDATE_THREADS)
+        {
+            stats_halt_count++;
+            if ((stats_period != 0u) && ((stats_halt_count % stats_period) == 0u))
+            {
+                STATS_report();
+            }
+        }
+    }
+}
+
+/** \brief Add a value to a counter */
+void STATS_add(const stats_counter_t counter, const U32 value)
+{
+    if (stats_enabled)
+    {
+        stats_values[counter] += value;
+    }
+}
+
+/** \brief Keep the highest value of a counter */
+void STATS_max(const stats_counter_t counter, const U32 value)
+{
+    if (stats_enabled && (value > stats_values[counter]))
+    {
+        stats_values[counter] = value;
+    }
+}
+
+/** \brief Get the number of bytes read through the GDB server since the start of the session (0 if the counters are not enabled) */
+U32 STATS_getReadBytes(void)
+{
+    return stats_read_bytes;
+}
+
+/** \brief Report the counters of the current session and start a new one (the GDB server log can't be used
+           at the end of the process, so the end of a session is either a new initialization or a target reset) */
+void STATS_endSession(void)
+{
+    STATS_report();
+    memset(stats_counters, 0, sizeof(stats_counters));
+    memset(stats_values, 0, sizeof(stats_values));
+    stats_read_bytes = 0u;
+    stats_halt_count = 0u;
+}
+
+/** \brief Report the counters through the GDB server log */
+void STATS_report(void)
+{
+    if (stats_enabled)
+    {
+        U32 i;
+        U32 bucket;
+
+        stats_target_api->pfLogOutf("Nano-OS plugin: statistics over %u halts\n", stats_halt_count);
+        for (i = 0u; i < STATS_ENTRY_MAX; i++)
+        {
+            const stats_counters_t* const counters = &stats_counters[i];
+            if ((counters->calls != 0u) || (counters->read_calls != 0u) || (counters->write_calls != 0u))
+            {
+                char histogram[STATS_HISTOGRAM_SIZE * 24u];
+                size_t histogram_length = 0u;
+                const U32 average_time = (counters->calls != 0u) ? (U32)(counters->total_time / counters->calls) : 0u;
+
+                /* Only report the non empty buckets */
+                histogram[0u] = 0;
+                for (bucket = 0u; bucket < STATS_HISTOGRAM_SIZE; bucket++)
+                {
+                    if (counters->histogram[bucket] != 0u)
+                    {
+                        histogram_length += (size_t)snprintf(&histogram[histogram_length], sizeof(histogram) - histogram_length,
+                                                             " <%uus:%u", (1u << bucket), counters->histogram[bucket]);
+                    }
+                }
+
+                stats_target_api->pfLogOutf("  %-24s calls=%u reads=%u bytes=%u writes=%u time=%lluus avg=%uus max=%uus\n",
+                                            stats_entry_names[i], counters->calls, counters->read_calls, counters->read_bytes,
+                                            counters->write_calls, (unsigned long long)counters->total_time, average_time, counters->max_time);
+                if (histogram_length != 0u)
+                {
+                    stats_target_api->pfLogOutf("  %-24s latency%s\n", "", histogram);
+                }
+            }
+        }
+        for (i = 0u; i < STATS_COUNTER_MAX; i++)
+        {
+            stats_target_api->pfLogOutf("  %-24s %u\n", stats_counter_names[i], stats_values[i]);
+        }
+    }
+}
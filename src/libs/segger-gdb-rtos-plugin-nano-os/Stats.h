@@ -0,0 +1,143 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Enable the build of the probe transaction and latency counters */
+#define STATS_ENABLED               1
+
+/** \brief Name of the environment variable enabling the counters, its value is the number of halts
+           between 2 summaries (0 = summary only at the end of the session) */
+#define STATS_PERIOD_ENV_VAR        "NANO_OS_PLUGIN_STATS_PERIOD"
+
+/** \brief Number of buckets of the latency histograms (bucket n counts the calls lasting less than 2^n us) */
+#define STATS_HISTOGRAM_SIZE        24u
+
+
+/** \brief Instrumented entry points */
+typedef enum _stats_entry_t
+{
+    /** \brief RTOS_GetNumThreads() */
+    STATS_ENTRY_GET_NUM_THREADS = 0u,
+    /** \brief RTOS_GetCurrentThreadId() */
+    STATS_ENTRY_GET_CURRENT_THREAD_ID,
+    /** \brief RTOS_GetThreadId() */
+    STATS_ENTRY_GET_THREAD_ID,
+    /** \brief RTOS_GetThreadDisplay() */
+    STATS_ENTRY_GET_THREAD_DISPLAY,
+    /** \brief RTOS_GetThreadReg() */
+    STATS_ENTRY_GET_THREAD_REG,
+    /** \brief RTOS_GetThreadRegList() */
+    STATS_ENTRY_GET_THREAD_REG_LIST,
+    /** \brief RTOS_SetThreadReg() */
+    STATS_ENTRY_SET_THREAD_REG,
+    /** \brief RTOS_SetThreadRegList() */
+    STATS_ENTRY_SET_THREAD_REG_LIST,
+    /** \brief RTOS_UpdateThreads() */
+    STATS_ENTRY_UPDATE_THREADS,
+    /** \brief Accesses outside of the entry points */
+    STATS_ENTRY_OTHER,
+
+    /** \brief Number of entries */
+    STATS_ENTRY_MAX
+} stats_entry_t;
+
+/** \brief Counters of the plugin internals */
+typedef enum _stats_counter_t
+{
+    /** \brief Target reads issued to prefetch the task control blocks */
+    STATS_COUNTER_TCB_PREFETCH_TRANSFERS = 0u,
+    /** \brief Target reads issued to read the wait objects and the saved contexts */
+    STATS_COUNTER_DEFERRED_TRANSFERS,
+    /** \brief Highest number of bytes of transient memory used by an update */
+    STATS_COUNTER_TRANSIENT_MEMORY_PEAK,
+    /** \brief Number of bytes of transient memory allocated */
+    STATS_COUNTER_TRANSIENT_MEMORY_SIZE,
+    /** \brief Number of bytes of the names stored in the name pool */
+    STATS_COUNTER_NAME_POOL_SIZE,
+    /** \brief Number of bytes read through the GDB server to get the strings */
+    STATS_COUNTER_STRING_BYTES,
+    /** \brief Number of bytes saved on the strings compared to reading each string with a fixed size read (a string costing more saves nothing) */
+    STATS_COUNTER_STRING_BYTES_SAVED,
+
+    /** \brief Number of counters */
+    STATS_COUNTER_MAX
+} stats_counter_t;
+
+
+#if (STATS_ENABLED == 1)
+
+/** \brief Macro to mark the start of an instrumented entry point */
+#define STATS_ENTER(entry)          STATS_enter(entry)
+
+/** \brief Macro to mark the end of an instrumented entry point */
+#define STATS_LEAVE(entry)          STATS_leave(entry)
+
+/** \brief Macro to add a value to a counter */
+#define STATS_ADD(counter, value)   STATS_add(counter, value)
+
+/** \brief Macro to keep the highest value of a counter */
+#define STATS_MAX(counter, value)   STATS_max(counter, value)
+
+/** \brief Macro to report the counters of the current session and start a new one */
+#define STATS_END_SESSION()         STATS_endSession()
+
+#else
+
+#define STATS_ENTER(entry)
+#define STATS_LEAVE(entry)
+#define STATS_ADD(counter, value)   (void)(value)
+#define STATS_MAX(counter, value)   (void)(value)
+#define STATS_END_SESSION()
+
+#endif /* (STATS_ENABLED == 1) */
+
+
+/** \brief Start a new session, report the counters of the previous one and get the counting API
+           (the given API is returned as is if the counters are not enabled) */
+const GDB_API* STATS_init(const GDB_API* const target_api);
+
+/** \brief Start measuring an entry point */
+void STATS_enter(const stats_entry_t entry);
+
+/** \brief Stop measuring an entry point, a summary is reported every configured number of halts */
+void STATS_leave(const stats_entry_t entry);
+
+/** \brief Add a value to a counter */
+void STATS_add(const stats_counter_t counter, const U32 value);
+
+/** \brief Keep the highest value of a counter */
+void STATS_max(const stats_counter_t counter, const U32 value);
+
+/** \brief Get the number of bytes read through the GDB server since the start of the session (0 if the counters are not enabled) */
+U32 STATS_getReadBytes(void);
+
+/** \brief Report the counters of the current session and start a new one (the GDB server log can't be used
+           at the end of the process, so the end of a session is either a new initialization or a target reset) */
+void STATS_endSession(void);
+
+/** \brief Report the counters through the GDB server log */
+void STATS_report(void);
+
+
+#endif /* STATS_H */
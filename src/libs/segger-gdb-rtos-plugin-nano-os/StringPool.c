@@ -0,0 +1,220 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StringPool.h"
+
+
+
+/** \brief Compute the hash of a string */
+static U32 STRINGPOOL_hash(const char* const string)
+{
+    /* FNV-1a hash */
+    U32 hash = 2166136261u;
+    const U8* c = (const U8*)string;
+    while ((*c) != 0u)
+    {
+        hash = (hash ^ (*c)) * 16777619u;
+        c++;
+    }
+    return hash;
+}
+
+/** \brief Get the slot of a string in the hash index, or the free slot where to add it */
+static U32 STRINGPOOL_findSlot(const stringpool_t* const pool, const char* const string, const U32 hash)
+{
+    const U32 mask = pool->index_size - 1u;
+    U32 slot = hash & mask;
+
+    /* Probe the slots until the string or a free slot is found */
+    while ((pool->index[slot] != 0u) && (strcmp(&pool->storage[pool->index[slot]], string) != 0))
+    {
+        slot = (slot + 1u) & mask;
+    }
+
+    return slot;
+}
+
+/** \brief Make room for a string of the given length and for its entry in the hash index */
+static bool STRINGPOOL_reserve(stringpool_t* const pool, const GDB_API* const gdb_api, const U32 length)
+{
+    bool ret = true;
+
+    /* Grow the storage, the handles are offsets so they stay valid */
+    if ((pool->storage_used + length + 1u) > pool->storage_size)
+    {
+        char* storage;
+        U32 size = ((pool->storage_size != 0u) ? pool->storage_size : STRINGPOOL_MIN_STORAGE_SIZE);
+        while (size < (pool->storage_used + length + 1u))
+        {
+            size *= 2u;
+        }
+        storage = (char*)gdb_api->pfRealloc(pool->storage, size);
+        if (storage != NULL)
+        {
+            if (pool->storage == NULL)
+            {
+                /* The empty string is at offset 0 */
+                storage[0u] = 0;
+                pool->storage_used = 1u;
+            }
+            pool->storage = storage;
+            pool->storage_size = size;
+        }
+        else
+        {
+            ret = false;
+        }
+    }
+
+    /* Keep the hash index at most half full */
+    if (ret && (((pool->string_count + 1u) * 2u) > pool->index_size))
+    {
+        const U32 size = ((pool->index_size != 0u) ? (2u * pool->index_size) : STRINGPOOL_MIN_INDEX_SIZE);
+        U32* const index = (U32*)gdb_api->pfAlloc(size * sizeof(U32));
+        if (index != NULL)
+        {
+            U32 i;
+            U32* const previous_index = pool->index;
+            const U32 previous_size = pool->index_size;
+            memset(index, 0, size * sizeof(U32));
+            pool->index = index;
+            pool->index_size = size;
+            for (i = 0u; i < previous_size; i++)
+            {
+                const U32 handle = previous_index[i];
+                if (handle != 0u)
+                {
+                    const char* const string = &pool->storage[handle];
+                    index[STRINGPOOL_findSlot(pool, string, STRINGPOOL_hash(string))] = handle;
+                }
+            }
+            if (previous_index != NULL)
+            {
+                gdb_api->pfFree(previous_index);
+            }
+        }
+        else
+        {
+            ret = false;
+        }
+    }
+
+    return ret;
+}
+
+
+/** \brief Remove all the strings of a pool, all the handles become invalid */
+void STRINGPOOL_reset(stringpool_t* const pool)
+{
+    if (pool->storage != NULL)
+    {
+        pool->storage_used = 1u;
+    }
+    if (pool->index != NULL)
+    {
+        memset(pool->index, 0, pool->index_size * sizeof(U32));
+    }
+    pool->string_count = 0u;
+}
+
+/** \brief Get the handle of a string, adding it to the pool if it is not already in (returns false if the pool can't grow) */
+bool STRINGPOOL_intern(stringpool_t* const pool, const GDB_API* const gdb_api, const char* const string, U32* const handle)
+{
+    bool ret = true;
+
+    (*handle) = STRINGPOOL_EMPTY;
+    if (string[0u] != 0)
+    {
+        const U32 length = (U32)strlen(string);
+        const U32 hash = STRINGPOOL_hash(string);
+        U32 slot = 0u;
+
+        /* Look for the string */
+        if (pool->index != NULL)
+        {
+            slot = STRINGPOOL_findSlot(pool, string, hash);
+            (*handle) = pool->index[slot];
+        }
+
+        /* Add it at the end of the storage */
+        if ((*handle) == STRINGPOOL_EMPTY)
+        {
+            ret = STRINGPOOL_reserve(pool, gdb_api, length);
+            if (ret)
+            {
+                (*handle) = pool->storage_used;
+                memcpy(&pool->storage[pool->storage_used], string, length + 1u);
+                pool->storage_used += length + 1u;
+                pool->index[STRINGPOOL_findSlot(pool, string, hash)] = (*handle);
+                pool->string_count++;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/** \brief Get the handle of a string which is already in a pool (returns false if it is not in the pool) */
+bool STRINGPOOL_find(const stringpool_t* const pool, const char* const string, U32* const handle)
+{
+    bool ret = true;
+
+    (*handle) = STRINGPOOL_EMPTY;
+    if (string[0u] != 0)
+    {
+        if (pool->index != NULL)
+        {
+            (*handle) = pool->index[STRINGPOOL_findSlot(pool, string, STRINGPOOL_hash(string))];
+        }
+        ret = ((*handle) != STRINGPOOL_EMPTY);
+    }
+
+    return ret;
+}
+
+/** \brief Get the string of a handle */
+const char* STRINGPOOL_get(const stringpool_t* const pool, const U32 handle)
+{
+    const char* ret = "";
+    if (handle != STRINGPOOL_EMPTY)
+    {
+        ret = &pool->storage[handle];
+    }
+    return ret;
+}
+
+/** \brief Give back the memory of a pool to the GDB server */
+void STRINGPOOL_release(stringpool_t* const pool, const GDB_API* const gdb_api)
+{
+    if (pool->storage != NULL)
+    {
+        gdb_api->pfFree(pool->storage);
+    }
+    if (pool->index != NULL)
+    {
+        gdb_api->pfFree(pool->index);
+    }
+    memset(pool, 0, sizeof(stringpool_t));
+}
+
+/** \brief Get the number of bytes used to store the strings of a pool */
+U32 STRINGPOOL_getSize(const stringpool_t* const pool)
+{
+    return pool->storage_used;
+}
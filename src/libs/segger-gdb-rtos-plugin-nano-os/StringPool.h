@@ -0,0 +1,76 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include "RTOSPlugin.h"
+
+#include <stdbool.h>
+
+
+/** \brief Initial size in bytes of the string storage, doubled when full */
+#define STRINGPOOL_MIN_STORAGE_SIZE 4096u
+
+/** \brief Initial number of entries of the hash index (must be a power of 2), doubled when half full */
+#define STRINGPOOL_MIN_INDEX_SIZE   256u
+
+/** \brief Handle of the empty string, valid even if the pool is empty */
+#define STRINGPOOL_EMPTY            0u
+
+
+/** \brief Pool of null terminated strings, each distinct string is stored only once */
+typedef struct _stringpool_t
+{
+    /** \brief Storage of the strings, a handle is the offset of its string (the empty string is at offset 0) */
+    char* storage;
+    /** \brief Size in bytes of the storage */
+    U32 storage_size;
+    /** \brief Number of bytes used in the storage */
+    U32 storage_used;
+    /** \brief Hash index of the strings (open addressing on the string content, handle of the string or 0 if free) */
+    U32* index;
+    /** \brief Number of entries of the hash index */
+    U32 index_size;
+    /** \brief Number of strings in the pool */
+    U32 string_count;
+} stringpool_t;
+
+
+
+/** \brief Remove all the strings of a pool, all the handles become invalid */
+void STRINGPOOL_reset(stringpool_t* const pool);
+
+/** \brief Get the handle of a string, adding it to the pool if it is not already in (returns false if the pool can't grow) */
+bool STRINGPOOL_intern(stringpool_t* const pool, const GDB_API* const gdb_api, const char* const string, U32* const handle);
+
+/** \brief Get the handle of a string which is already in a pool (returns false if it is not in the pool) */
+bool STRINGPOOL_find(const stringpool_t* const pool, const char* const string, U32* const handle);
+
+/** \brief Get the string of a handle */
+const char* STRINGPOOL_get(const stringpool_t* const pool, const U32 handle);
+
+/** \brief Give back the memory of a pool to the GDB server */
+void STRINGPOOL_release(stringpool_t* const pool, const GDB_API* const gdb_api);
+
+/** \brief Get the number of bytes used to store the strings of a pool */
+U32 STRINGPOOL_getSize(const stringpool_t* const pool);
+
+
+#endif /* STRINGPOOL_H */
@@ -0,0 +1,43 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Timer.h"
+
+#ifndef WIN32
+  #include <time.h>
+#endif
+
+
+/** \brief Get the current time of a monotonic clock in us */
+U64 TIMER_getTime(void)
+{
+    U64 ret;
+#ifdef WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    ret = (U64)((counter.QuadPart / frequency.QuadPart) * 1000000) + (U64)(((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ret = ((U64)now.tv_sec * 1000000u) + ((U64)now.tv_nsec / 1000u);
+#endif
+    return ret;
+}
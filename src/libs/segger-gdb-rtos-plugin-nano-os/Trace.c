@@ -0,0 +1,209 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Trace.h"
+#include "Timer.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+
+
+/** \brief GDB server API used to access the target */
+static const GDB_API* trace_target_api = NULL;
+
+/** \brief Tracing API */
+static GDB_API trace_api;
+
+/** \brief Trace file */
+static FILE* trace_file = NULL;
+
+/** \brief Number of events written to the trace file */
+static U32 trace_event_count = 0u;
+
+/** \brief Write buffer */
+static char trace_buffer[TRACE_BUFFER_SIZE];
+
+/** \brief Number of bytes in the write buffer */
+static U32 trace_buffer_length = 0u;
+
+
+
+/** \brief Add an event to the write buffer */
+static void TRACE_write(const char* const format, ...)
+{
+    int length;
+    va_list args;
+
+    /* Events are separated by a comma */
+    if (trace_event_count != 0u)
+    {
+        if (trace_buffer_length >= (TRACE_BUFFER_SIZE - 2u))
+        {
+            TRACE_flush();
+        }
+        trace_buffer[trace_buffer_length] = ',';
+        trace_buffer[trace_buffer_length + 1u] = '\n';
+        trace_buffer_length += 2u;
+    }
+
+    /* Format the event, the buffer is written to the file if it is too small */
+    va_start(args, format);
+    length = vsnprintf(&trace_buffer[trace_buffer_length], TRACE_BUFFER_SIZE - trace_buffer_length, format, args);
+    va_end(args);
+    if ((length > 0) && ((U32)length >= (TRACE_BUFFER_SIZE - trace_buffer_length)))
+    {
+        TRACE_flush();
+        va_start(args, format);
+        length = vsnprintf(trace_buffer, TRACE_BUFFER_SIZE, format, args);
+        va_end(args);
+    }
+    if (length > 0)
+    {
+        trace_buffer_length += (U32)length;
+        trace_event_count++;
+    }
+}
+
+/** \brief Terminate and close the trace file at the end of the process */
+static void TRACE_close(void)
+{
+    if (trace_file != NULL)
+    {
+        TRACE_flush();
+        fputs("\n]\n", trace_file);
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+}
+
+/** \brief Add a target read event to the write buffer */
+static void TRACE_writeRead(const char* const name, const U32 address, const U32 size, const U64 start_time)
+{
+    const U64 end_time = TIMER_getTime();
+    TRACE_write("{\"name\":\"%s\",\"cat\":\"probe\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":1,\"args\":{\"address\":\"0x%08x\",\"size\":%u}}",
+                name, (unsigned long long)start_time, (unsigned long long)(end_time - start_time), address, size);
+}
+
+/** \brief Read a memory area */
+static int TRACE_ReadMem(U32 Addr, char* pData, unsigned int NumBytes)
+{
+    const U64 start_time = TIMER_getTime();
+    const int ret = trace_target_api->pfReadMem(Addr, pData, NumBytes);
+    TRACE_writeRead("ReadMem", Addr, NumBytes, start_time);
+    return ret;
+}
+
+/** \brief Read a byte */
+static char TRACE_ReadU8(U32 Addr, U8* pData)
+{
+    const U64 start_time = TIMER_getTime();
+    const char ret = trace_target_api->pfReadU8(Addr, pData);
+    TRACE_writeRead("ReadU8", Addr, 1u, start_time);
+    return ret;
+}
+
+/** \brief Read a half word */
+static char TRACE_ReadU16(U32 Addr, U16* pData)
+{
+    const U64 start_time = TIMER_getTime();
+    const char ret = trace_target_api->pfReadU16(Addr, pData);
+    TRACE_writeRead("ReadU16", Addr, 2u, start_time);
+    return ret;
+}
+
+/** \brief Read a word */
+static char TRACE_ReadU32(U32 Addr, U32* pData)
+{
+    const U64 start_time = TIMER_getTime();
+    const char ret = trace_target_api->pfReadU32(Addr, pData);
+    TRACE_writeRead("ReadU32", Addr, 4u, start_time);
+    return ret;
+}
+
+
+/** \brief Open the trace file if configured and get the API tracing the target reads
+           (the given API is returned as is if no trace file is configured) */
+const GDB_API* TRACE_init(const GDB_API* const target_api)
+{
+    const GDB_API* ret = target_api;
+    const char* const path = getenv(TRACE_FILE_ENV_VAR);
+
+    /* The trace file is kept open across the sessions so that the whole debug session is recorded */
+    if ((TRACE_ENABLED == 1) && (trace_file == NULL) && (path != NULL) && (path[0u] != 0))
+    {
+        trace_file = fopen(path, "w");
+        if (trace_file != NULL)
+        {
+            /* Start the event array */
+            fputs("[\n", trace_file);
+            trace_event_count = 0u;
+            trace_buffer_length = 0u;
+            (void)atexit(TRACE_close);
+            target_api->pfLogOutf("Nano-OS plugin: writing trace to %s\n", path);
+        }
+        else
+        {
+            target_api->pfWarnOutf("Nano-OS plugin: unable to open trace file %s\n", path);
+        }
+    }
+    if (trace_file != NULL)
+    {
+        /* Build the tracing API */
+        trace_target_api = target_api;
+        trace_api = (*target_api);
+        trace_api.pfReadMem = TRACE_ReadMem;
+        trace_api.pfReadU8 = TRACE_ReadU8;
+        trace_api.pfReadU16 = TRACE_ReadU16;
+        trace_api.pfReadU32 = TRACE_ReadU32;
+        ret = &trace_api;
+    }
+
+    return ret;
+}
+
+/** \brief Start a span */
+void TRACE_begin(const char* const name)
+{
+    if (trace_file != NULL)
+    {
+        TRACE_write("{\"name\":\"%s\",\"cat\":\"plugin\",\"ph\":\"B\",\"ts\":%llu,\"pid\":1,\"tid\":1}", name, (unsigned long long)TIMER_getTime());
+    }
+}
+
+/** \brief End a span */
+void TRACE_end(const char* const name)
+{
+    if (trace_file != NULL)
+    {
+        TRACE_write("{\"name\":\"%s\",\"cat\":\"plugin\",\"ph\":\"E\",\"ts\":%llu,\"pid\":1,\"tid\":1}", name, (unsigned long long)TIMER_getTime());
+    }
+}
+
+/** \brief Write the buffered events to the trace file */
+void TRACE_flush(void)
+{
+    if ((trace_file != NULL) && (trace_buffer_length != 0u))
+    {
+        (void)fwrite(trace_buffer, 1u, trace_buffer_length, trace_file);
+        (void)fflush(trace_file);
+        trace_buffer_length = 0u;
+    }
+}
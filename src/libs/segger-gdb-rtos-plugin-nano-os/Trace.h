@@ -0,0 +1,71 @@
+/*
+Copyright(c) 2017 Cedric Jimenez
+
+This file is part of Nano-OS.
+
+Nano-OS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Nano-OS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with Nano-OS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "RTOSPlugin.h"
+
+
+/** \brief Enable the build of the trace file export */
+#define TRACE_ENABLED               1
+
+/** \brief Name of the environment variable containing the path to the trace file (Chrome trace event format,
+           the file is flushed after each update and terminated at the end of the process) */
+#define TRACE_FILE_ENV_VAR          "NANO_OS_PLUGIN_TRACE_FILE"
+
+/** \brief Size in bytes of the trace file write buffer */
+#define TRACE_BUFFER_SIZE           65536u
+
+
+#if (TRACE_ENABLED == 1)
+
+/** \brief Macro to mark the start of a traced span */
+#define TRACE_BEGIN(name)           TRACE_begin(name)
+
+/** \brief Macro to mark the end of a traced span */
+#define TRACE_END(name)             TRACE_end(name)
+
+/** \brief Macro to write the buffered events to the trace file */
+#define TRACE_FLUSH()               TRACE_flush()
+
+#else
+
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_FLUSH()
+
+#endif /* (TRACE_ENABLED == 1) */
+
+
+/** \brief Open the trace file if configured and get the API tracing the target reads
+           (the given API is returned as is if no trace file is configured) */
+const GDB_API* TRACE_init(const GDB_API* const target_api);
+
+/** \brief Start a span */
+void TRACE_begin(const char* const name);
+
+/** \brief End a span */
+void TRACE_end(const char* const name);
+
+/** \brief Write the buffered events to the trace file */
+void TRACE_flush(void);
+
+
+#endif /* TRACE_H */